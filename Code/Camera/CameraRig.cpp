@@ -0,0 +1,88 @@
+#include "StdAfx.h"
+#include "CameraRig.h"
+
+namespace
+{
+    // Angular difference below which smoothing snaps to the target and the rig goes idle
+    constexpr float kSettleAngle = 0.0001f;
+}
+
+void CCameraRig::SetSettings(const SSettings& settings)
+{
+    if (m_settings == settings)
+        return;
+
+    m_settings = settings;
+    m_targetPitch = crymath::clamp(m_targetPitch, m_settings.minPitch, m_settings.maxPitch);
+    m_dirty = true;
+}
+
+void CCameraRig::AddLookInput(const Vec2& mouseDelta)
+{
+    if (mouseDelta.IsZero())
+        return;
+
+    m_targetYaw += mouseDelta.x * m_settings.rotationSpeed;
+
+    // Keep the angles small, the evaluated yaw moves with the target so smoothing doesn't spin around
+    if (fabs_tpl(m_targetYaw) > gf_PI2)
+    {
+        const float wrap = m_targetYaw > 0.f ? -gf_PI2 : gf_PI2;
+        m_targetYaw += wrap;
+        m_yaw += wrap;
+    }
+
+    // Soft clamp, input towards a pitch limit fades out over the soft zone instead of hitting a wall
+    float pitchDelta = mouseDelta.y * m_settings.rotationSpeed;
+    if (m_settings.pitchSoftZone > 0.f)
+    {
+        const float distanceToLimit = pitchDelta > 0.f ? m_settings.maxPitch - m_targetPitch : m_targetPitch - m_settings.minPitch;
+        pitchDelta *= crymath::clamp(distanceToLimit / m_settings.pitchSoftZone, 0.f, 1.f);
+    }
+
+    m_targetPitch = crymath::clamp(m_targetPitch + pitchDelta, m_settings.minPitch, m_settings.maxPitch);
+    m_dirty = true;
+}
+
+bool CCameraRig::Update(const float frameTime, const Quat& entityRotation)
+{
+    if (!Quat::IsEquivalent(entityRotation, m_entityRotation))
+    {
+        m_entityRotation = entityRotation;
+        m_dirty = true;
+    }
+
+    const bool converging = m_yaw != m_targetYaw || m_pitch != m_targetPitch;
+    if (!m_dirty && !converging)
+        return false;
+
+    if (m_settings.smoothing > 0.f)
+    {
+        // Frame rate independent exponential approach
+        const float blend = 1.f - exp_tpl(-m_settings.smoothing * frameTime);
+        m_yaw += (m_targetYaw - m_yaw) * blend;
+        m_pitch += (m_targetPitch - m_pitch) * blend;
+
+        if (fabs_tpl(m_targetYaw - m_yaw) < kSettleAngle && fabs_tpl(m_targetPitch - m_pitch) < kSettleAngle)
+        {
+            m_yaw = m_targetYaw;
+            m_pitch = m_targetPitch;
+        }
+    }
+    else
+    {
+        m_yaw = m_targetYaw;
+        m_pitch = m_targetPitch;
+    }
+
+    m_dirty = false;
+
+    // View rotation is the look orientation relative to the entity
+    m_localTransform.SetRotation33(
+        Matrix33(m_entityRotation.GetInverted()) * CCamera::CreateOrientationYPR(Ang3(m_yaw, m_pitch, 0.f)));
+
+    // Offset the camera along the backward axis
+    m_localTransform.SetTranslation(-m_localTransform.GetColumn1() * m_settings.viewDistance);
+
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+////////////////////////////////////////////////////////
+// Third person orbit camera around the owning entity
+//
+// The evaluated camera transform is cached and only recomputed when look input arrives,
+// the entity turns, the settings change or smoothing is still converging. Idle frames
+// report no change, so the camera and audio listener don't have to be touched.
+////////////////////////////////////////////////////////
+class CCameraRig
+{
+public:
+    struct SSettings
+    {
+        // Radians per unit of mouse input
+        float rotationSpeed = 0.002f;
+        float minPitch = -1.2f;
+        float maxPitch = 0.05f;
+        // Pitch input slows down linearly over this many radians before reaching a limit
+        float pitchSoftZone = 0.25f;
+        float viewDistance = 4.f;
+        // Rate at which the camera follows the look input, 0 follows it immediately
+        float smoothing = 0.f;
+
+        bool operator==(const SSettings& other) const
+        {
+            return rotationSpeed == other.rotationSpeed && minPitch == other.minPitch && maxPitch == other.maxPitch &&
+                pitchSoftZone == other.pitchSoftZone && viewDistance == other.viewDistance && smoothing == other.smoothing;
+        }
+        bool operator!=(const SSettings& other) const { return !(*this == other); }
+    };
+
+    void SetSettings(const SSettings& settings);
+    const SSettings& GetSettings() const { return m_settings; }
+
+    void AddLookInput(const Vec2& mouseDelta);
+
+    // Forces the next update to report a change, e.g. when a new camera starts using the rig
+    void Invalidate() { m_dirty = true; }
+
+    // Returns true when the camera transform changed since the last update
+    bool Update(float frameTime, const Quat& entityRotation);
+
+    // Camera transform relative to the entity
+    const Matrix34& GetLocalTransform() const { return m_localTransform; }
+    Quat GetLookOrientation() const { return Quat(CCamera::CreateOrientationYPR(Ang3(m_yaw, m_pitch, 0.f))); }
+
+private:
+    SSettings m_settings;
+
+    // Requested by input
+    float m_targetYaw = 0.f;
+    float m_targetPitch = 0.f;
+    // Evaluated, trails the target while smoothing
+    float m_yaw = 0.f;
+    float m_pitch = 0.f;
+
+    Quat m_entityRotation = IDENTITY;
+    Matrix34 m_localTransform = IDENTITY;
+    bool m_dirty = true;
+};
@@ -8,6 +8,7 @@
 #include <CryNetwork/Rmi.h>
 
 #include "GamePlugin.h"
+#include "GameCVars.h"
 
 namespace
 {
@@ -24,15 +25,37 @@ namespace
 }
 
 
-CPlayerComponent::CPlayerComponent() : m_animations({
-    {1, {"idle", 0, 3, 0, 5.f, true}},
-    {2, {"moving", 0, 5, 1, 8.f, true}},
-    {4, {"jump", 0, 5, 2, 13.5f, false}},
-    {5, {"fall", 6, 7, 2, 5.f, true}},
-    {6, {"attack", 4, 7, 5, 5.f, false}},
+namespace
+{
+    // Frames are relative to the start frame of the clip
+    const SFlipbookEventMarker s_movingMarkers[] = {
+        {1, EFlipbookEvent::Footstep},
+        {4, EFlipbookEvent::Footstep},
+    };
+
+    const SFlipbookEventMarker s_attackMarkers[] = {
+        {2, EFlipbookEvent::Hit},
+    };
+}
 
-})
+// Shared by every player instance, indexed by clip id
+const CPlayerComponent::SPlayerClip CPlayerComponent::s_clips[] = {
+    {1, {"idle", 0, 3, 0, 5.f, true, nullptr, 0}},
+    {2, {"moving", 0, 5, 1, 8.f, true, s_movingMarkers, CRY_ARRAY_COUNT(s_movingMarkers)}},
+    {4, {"jump", 0, 5, 2, 13.5f, false, nullptr, 0}},
+    {5, {"fall", 6, 7, 2, 5.f, true, nullptr, 0}},
+    {6, {"attack", 4, 7, 5, 5.f, false, s_attackMarkers, CRY_ARRAY_COUNT(s_attackMarkers)}},
+};
+
+const FFlipbookAnim* CPlayerComponent::FindClip(const uint8 clipId)
 {
+    for (const SPlayerClip& clip : s_clips)
+    {
+        if (clip.id == clipId)
+            return &clip.anim;
+    }
+
+    return nullptr;
 }
 
 void CPlayerComponent::Initialize()
@@ -50,22 +73,52 @@ void CPlayerComponent::Initialize()
 
     m_pSpriteFlipbookComponent = m_pEntity->GetOrCreateComponent<CSpriteFlipbookComponent>();
 
-    InitializeLocalPlayer();
+    // Mark the entity to be replicated over the network
+    m_pEntity->GetNetEntity()->BindToNetwork();
+
+    // Position is replicated through our own quantized snapshots, the physics aspect would only duplicate it
+    m_pEntity->GetNetEntity()->EnableAspect(eEA_Physics, false);
+
+    // Allow the owning client to send its input to the server
+    m_pEntity->GetNetEntity()->EnableDelegatableAspect(InputAspect, false);
+
+    // Spawned for the local client, players placed in the level are resolved once gameplay starts
+    if (m_pEntity->GetFlags() & ENTITY_FLAG_LOCAL_PLAYER)
+    {
+        InitializeLocalPlayer();
+    }
 }
 
 void CPlayerComponent::InitializeLocalPlayer()
 {
-    // Create the camera component, will automatically update the viewport every frame
-    m_pCameraComponent = m_pEntity->GetOrCreateComponent<Cry::DefaultComponents::CCameraComponent>();
+    if (m_isLocalPlayer)
+        return;
+
+    m_isLocalPlayer = true;
 
     // Create the camera component, will automatically update the viewport every frame
     m_pCameraComponent = m_pEntity->GetOrCreateComponent<Cry::DefaultComponents::CCameraComponent>();
+    m_cameraRig.Invalidate();
 
     // Create the audio listener component.
     m_pAudioListenerComponent = m_pEntity->GetOrCreateComponent<Cry::Audio::DefaultComponents::CListenerComponent>();
 
     // Get the input component, wraps access to action mapping so we can easily get callbacks when inputs are m_pEntity
     m_pInputComponent = m_pEntity->GetOrCreateComponent<Cry::DefaultComponents::CInputComponent>();
+
+    RegisterInputActions();
+}
+
+void CPlayerComponent::OnReadyForGameplayOnServer()
+{
+    CRY_ASSERT(gEnv->bServer, "This function should only be called on the server!");
+
+    m_isAlive = true;
+
+    // Force a full snapshot, so the new client does not wait for the next change
+    m_snapshot = CaptureSnapshot();
+    m_snapshotTimer = 0.f;
+    NetMarkAspectsDirty(MovementAspect | StateAspect);
 }
 
 void CPlayerComponent::EnterState(EPlayerState newState)
@@ -75,17 +128,19 @@ void CPlayerComponent::EnterState(EPlayerState newState)
 
     m_state = newState;
     m_stateTime = 0.f;
+    m_stateClipFinished = false;
 
-    if (newState == EPlayerState::Idle)
-        m_pSpriteFlipbookComponent->Play(m_animations.at(1));
-    else if (newState == EPlayerState::Moving)
-        m_pSpriteFlipbookComponent->Play(m_animations.at(2));
-    else if (newState == EPlayerState::Jumping)
-        m_pSpriteFlipbookComponent->Play(m_animations.at(4));
-    else if (newState == EPlayerState::Falling)
-        m_pSpriteFlipbookComponent->Play(m_animations.at(5));
-    else if (newState == EPlayerState::Attacking)
-        m_pSpriteFlipbookComponent->Play(m_animations.at(6));
+    PlayClip(GetClipIdForState(newState));
+}
+
+void CPlayerComponent::PlayClip(const uint8 clipId)
+{
+    const FFlipbookAnim* pClip = FindClip(clipId);
+    if (!pClip)
+        return;
+
+    m_currentClipId = clipId;
+    m_pSpriteFlipbookComponent->Play(*pClip);
 }
 
 Cry::Entity::EventFlags CPlayerComponent::GetEventMask() const
@@ -101,73 +156,24 @@ void CPlayerComponent::ProcessEvent(const SEntityEvent& event)
 {
     switch (event.event)
     {
+    case Cry::Entity::EEvent::BecomeLocalPlayer:
+        {
+            InitializeLocalPlayer();
+        }
+        break;
     case Cry::Entity::EEvent::GameplayStarted:
         {
+            // Counters keep running so the owner and the server stay in step, only pending presses are dropped
             m_inputFlags.Clear();
+            m_jumpPresses.processedCount = m_jumpPresses.count;
+            m_attackPresses.processedCount = m_attackPresses.count;
             m_isAlive = true;
 
-            // Register an action, and the callback that will be sent when it's m_pEntity
-            m_pInputComponent->RegisterAction("player", "moveleft", [this](int activationMode, float value)
-            {
-                HandleInputFlagChange(EInputFlag::MoveLeft,
-                                      (EActionActivationMode)activationMode);
-            });
-            // Bind the 'A' key the "moveleft" action
-            m_pInputComponent->BindAction("player", "moveleft", eAID_KeyboardMouse, EKeyId::eKI_A);
-
-            m_pInputComponent->RegisterAction("player", "moveright", [this](int activationMode, float value)
-            {
-                HandleInputFlagChange(EInputFlag::MoveRight,
-                                      (EActionActivationMode)activationMode);
-            });
-            m_pInputComponent->BindAction("player", "moveright", eAID_KeyboardMouse, EKeyId::eKI_D);
-
-            m_pInputComponent->RegisterAction("player", "moveforward", [this](int activationMode, float value)
-            {
-                HandleInputFlagChange(EInputFlag::MoveForward,
-                                      (EActionActivationMode)activationMode);
-            });
-            m_pInputComponent->BindAction("player", "moveforward", eAID_KeyboardMouse, EKeyId::eKI_W);
-
-            m_pInputComponent->RegisterAction("player", "moveback", [this](int activationMode, float value)
+            // Players placed in the level (e.g. in the editor) are not owned by any client channel, drive them locally
+            if (gEnv->bServer && !gEnv->IsDedicated() && m_pEntity->GetNetEntity()->GetChannelId() == 0)
             {
-                HandleInputFlagChange(EInputFlag::MoveBack,
-                                      (EActionActivationMode)activationMode);
-            });
-            m_pInputComponent->BindAction("player", "moveback", eAID_KeyboardMouse, EKeyId::eKI_S);
-
-            m_pInputComponent->RegisterAction("player", "mouse_rotateyaw", [this](int activationMode, float value)
-            {
-                m_mouseDeltaRotation.x -= value;
-            });
-            m_pInputComponent->BindAction("player", "mouse_rotateyaw", eAID_KeyboardMouse, EKeyId::eKI_MouseX);
-
-            m_pInputComponent->RegisterAction("player", "mouse_rotatepitch", [this](int activationMode, float value)
-            {
-                m_mouseDeltaRotation.y -= value;
-            });
-            m_pInputComponent->BindAction("player", "mouse_rotatepitch", eAID_KeyboardMouse, EKeyId::eKI_MouseY);
-
-            // Register the shoot action
-            m_pInputComponent->RegisterAction("player", "jump", [this](int activationMode, float value)
-            {
-                // Only jump if the button was pressed
-                if (activationMode == eAAM_OnPress && m_pCharacterController->IsOnGround())
-                {
-                    m_pCharacterController->AddVelocity(Vec3(0, 0, 5.f));
-                }
-            });
-
-            // Bind the jump action to the space bar
-            m_pInputComponent->BindAction("player", "jump", eAID_KeyboardMouse, EKeyId::eKI_Space);
-            m_pInputComponent->RegisterAction("player", "attack", [this](int activationMode, float value)
-            {
-                if (activationMode == eAAM_OnPress && m_state != EPlayerState::Attacking)
-                {
-                    EnterState(EPlayerState::Attacking);
-                }
-            });
-            m_pInputComponent->BindAction("player", "attack", eAID_KeyboardMouse, EKeyId::eKI_Mouse1);
+                InitializeLocalPlayer();
+            }
         }
         break;
     case Cry::Entity::EEvent::Update:
@@ -178,15 +184,31 @@ void CPlayerComponent::ProcessEvent(const SEntityEvent& event)
 
             const float frameTime = event.fParam[0];
 
-            // Start by updating the movement request we want to send to the character controller
-            // This results in the physical representation of the character moving
-            UpdateMovementRequest(frameTime);
+            // The server is authoritative, the local client predicts its own player ahead of the snapshots
+            if (gEnv->bServer || m_isLocalPlayer)
+            {
+                // Start by updating the movement request we want to send to the character controller
+                // This results in the physical representation of the character moving
+                UpdateMovementRequest(frameTime);
 
-            // Update the player state
-            UpdatePlayerState(frameTime);
+                // Update the player state
+                UpdatePlayerState(frameTime);
+            }
+
+            if (gEnv->bServer)
+            {
+                UpdateReplication(frameTime);
+            }
+            else
+            {
+                ApplyServerPosition(frameTime);
+            }
 
             // Update the camera component offset
-            UpdateCamera(frameTime);
+            if (m_isLocalPlayer)
+            {
+                UpdateCamera(frameTime);
+            }
         }
         break;
     case Cry::Entity::EEvent::Reset:
@@ -198,9 +220,84 @@ void CPlayerComponent::ProcessEvent(const SEntityEvent& event)
     }
 }
 
+void CPlayerComponent::RegisterInputActions()
+{
+    // Register an action, and the callback that will be sent when it's m_pEntity
+    m_pInputComponent->RegisterAction("player", "moveleft", [this](int activationMode, float value)
+    {
+        HandleInputFlagChange(EInputFlag::MoveLeft,
+                              (EActionActivationMode)activationMode);
+    });
+    // Bind the 'A' key the "moveleft" action
+    m_pInputComponent->BindAction("player", "moveleft", eAID_KeyboardMouse, EKeyId::eKI_A);
+
+    m_pInputComponent->RegisterAction("player", "moveright", [this](int activationMode, float value)
+    {
+        HandleInputFlagChange(EInputFlag::MoveRight,
+                              (EActionActivationMode)activationMode);
+    });
+    m_pInputComponent->BindAction("player", "moveright", eAID_KeyboardMouse, EKeyId::eKI_D);
+
+    m_pInputComponent->RegisterAction("player", "moveforward", [this](int activationMode, float value)
+    {
+        HandleInputFlagChange(EInputFlag::MoveForward,
+                              (EActionActivationMode)activationMode);
+    });
+    m_pInputComponent->BindAction("player", "moveforward", eAID_KeyboardMouse, EKeyId::eKI_W);
+
+    m_pInputComponent->RegisterAction("player", "moveback", [this](int activationMode, float value)
+    {
+        HandleInputFlagChange(EInputFlag::MoveBack,
+                              (EActionActivationMode)activationMode);
+    });
+    m_pInputComponent->BindAction("player", "moveback", eAID_KeyboardMouse, EKeyId::eKI_S);
+
+    m_pInputComponent->RegisterAction("player", "mouse_rotateyaw", [this](int activationMode, float value)
+    {
+        m_mouseDeltaRotation.x -= value;
+    });
+    m_pInputComponent->BindAction("player", "mouse_rotateyaw", eAID_KeyboardMouse, EKeyId::eKI_MouseX);
+
+    m_pInputComponent->RegisterAction("player", "mouse_rotatepitch", [this](int activationMode, float value)
+    {
+        m_mouseDeltaRotation.y -= value;
+    });
+    m_pInputComponent->BindAction("player", "mouse_rotatepitch", eAID_KeyboardMouse, EKeyId::eKI_MouseY);
+
+    // Register the jump action, every press is counted so that quick taps survive replication
+    m_pInputComponent->RegisterAction("player", "jump", [this](int activationMode, float value)
+    {
+        HandleActionPress(m_jumpPresses, (EActionActivationMode)activationMode);
+    });
+
+    // Bind the jump action to the space bar
+    m_pInputComponent->BindAction("player", "jump", eAID_KeyboardMouse, EKeyId::eKI_Space);
+    m_pInputComponent->RegisterAction("player", "attack", [this](int activationMode, float value)
+    {
+        HandleActionPress(m_attackPresses, (EActionActivationMode)activationMode);
+    });
+    m_pInputComponent->BindAction("player", "attack", eAID_KeyboardMouse, EKeyId::eKI_Mouse1);
+}
+
+void CPlayerComponent::ProcessActionInputs()
+{
+    // Only jump if the button was pressed
+    if (m_jumpPresses.Consume() && m_pCharacterController->IsOnGround())
+    {
+        m_pCharacterController->AddVelocity(Vec3(0, 0, 5.f));
+        m_jumpStarted = true;
+    }
+
+    if (m_attackPresses.Consume() && m_state != EPlayerState::Attacking)
+    {
+        EnterState(EPlayerState::Attacking);
+    }
+}
 
 void CPlayerComponent::UpdateMovementRequest(float frameTime)
 {
+    ProcessActionInputs();
+
     // Don't handle input if we are in air
     if (!m_pCharacterController->IsOnGround())
     {
@@ -255,106 +352,287 @@ void CPlayerComponent::UpdateMovementRequest(float frameTime)
 void CPlayerComponent::UpdatePlayerState(float frameTime)
 {
     m_stateTime += frameTime;
-    gEnv->pRenderer->GetIRenderAuxGeom()->
-          Draw2dLabel(50, 50, 1.5f, Col_White, false, "State: %s", GetPlayerStateName());
+
+    if (m_isLocalPlayer && g_gameCVars.pl_debugState)
+    {
+        gEnv->pRenderer->GetIRenderAuxGeom()->
+              Draw2dLabel(50, 50, 1.5f, Col_White, false, "State: %s", GetPlayerStateName());
+    }
+
     Vec3 vel = m_pCharacterController->GetVelocity();
 
+    // Animation driven transitions, timed by the frames of the clips themselves
+    for (const SFlipbookEvent& animEvent : m_pSpriteFlipbookComponent->GetEvents())
+    {
+        HandleAnimationEvent(animEvent);
+    }
+
     switch (m_state)
     {
-    case EPlayerState::Attacking:
-        {
-            if (m_stateTime > 0.4f) // animation timing
-                EnterState(EPlayerState::Idle);
-        }
-        break;
     case EPlayerState::Jumping:
         {
-            if (m_stateTime > 0.1f && vel.z < 0.0f)
+            // Keep the take-off frames on screen, then fall as soon as we are descending
+            if (m_stateClipFinished && vel.z < 0.0f)
             {
                 EnterState(EPlayerState::Falling);
             }
         }
         break;
     case EPlayerState::Falling:
-        // Funny hack to switch to jump
-        if (vel.z > 0.1f && m_stateTime < 0.25f)
+        // Leaving the ground is seen as falling first, a jump we started switches to its clip once we rise
+        if (m_jumpStarted && vel.z > 0.1f)
         {
+            m_jumpStarted = false;
             EnterState(EPlayerState::Jumping);
             break;
         }
         if (m_pCharacterController->IsOnGround())
+        {
+            m_jumpStarted = false;
             EnterState(EPlayerState::Idle);
+        }
     default:
         break;
     }
 }
 
+void CPlayerComponent::HandleAnimationEvent(const SFlipbookEvent& animEvent)
+{
+    // Events left in the queue by a clip we have already replaced
+    if (!m_pSpriteFlipbookComponent->GetCurrentClip().IsClip(animEvent.clip))
+        return;
+
+    switch (animEvent.type)
+    {
+    case EFlipbookEvent::Hit:
+        {
+            CryLog("[Player] %s attack hit on frame %d", m_pEntity->GetName(), animEvent.frame);
+        }
+        break;
+    case EFlipbookEvent::ClipEnd:
+        {
+            m_stateClipFinished = true;
+
+            if (m_state == EPlayerState::Attacking)
+            {
+                EnterState(EPlayerState::Idle);
+            }
+        }
+        break;
+    case EFlipbookEvent::Footstep:
+        // Nothing to trigger until footstep audio exists
+        break;
+    }
+}
+
 void CPlayerComponent::UpdateCamera(float frameTime)
 {
-    // Start with updating look orientation from the latest input
-    Ang3 ypr = CCamera::CreateAnglesYPR(Matrix33(m_lookOrientation));
+    CCameraRig::SSettings settings = m_cameraRig.GetSettings();
+    settings.pitchSoftZone = g_gameCVars.cam_pitchSoftZone;
+    settings.viewDistance = g_gameCVars.cam_viewDistance;
+    settings.smoothing = g_gameCVars.cam_smoothing;
+    m_cameraRig.SetSettings(settings);
+
+    m_cameraRig.AddLookInput(m_mouseDeltaRotation);
+    m_mouseDeltaRotation = ZERO;
+
+    // Nothing moved, the camera and listener keep their last transform
+    if (!m_cameraRig.Update(frameTime, m_pEntity->GetWorldRotation()))
+        return;
+
+    // Look direction needs to be synced to server to calculate the movement in
+    // the right direction.
+    m_lookOrientation = m_cameraRig.GetLookOrientation();
+
+    const Matrix34& localTransform = m_cameraRig.GetLocalTransform();
+    m_pCameraComponent->SetTransformMatrix(localTransform);
+    m_pAudioListenerComponent->SetOffset(localTransform.GetTranslation());
+}
 
-    if (!m_mouseDeltaRotation.IsZero())
+bool CPlayerComponent::NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int flags)
+{
+    if (aspect == InputAspect)
     {
-        const float rotationSpeed = 0.002f;
+        ser.BeginGroup("PlayerInput");
 
-        ypr.x += m_mouseDeltaRotation.x * rotationSpeed;
+        auto inputs = m_inputFlags.UnderlyingValue();
+        ser.Value("m_inputFlags", inputs, 'ui8');
 
-        const float rotationLimitsMinPitch = -1.2;
-        const float rotationLimitsMaxPitch = 0.05f;
+        ser.Value("jumpPresses", m_jumpPresses.count, 'ui8');
+        ser.Value("attackPresses", m_attackPresses.count, 'ui8');
 
-        // TODO: Perform soft clamp here instead of hard wall, should reduce rot speed in this direction when close to limit.
-        ypr.y = CLAMP(ypr.y + m_mouseDeltaRotation.y * rotationSpeed, rotationLimitsMinPitch, rotationLimitsMaxPitch);
+        if (ser.IsReading())
+        {
+            m_inputFlags.SetWithUnderlyingValue(inputs);
+        }
 
-        // Look direction needs to be synced to server to calculate the movement in
-        // the right direction.
-        m_lookOrientation = Quat(CCamera::CreateOrientationYPR(ypr));
+        ser.EndGroup();
+    }
+    else if (aspect == MovementAspect)
+    {
+        ser.BeginGroup("PlayerMovement");
+        ser.Value("position", m_snapshot.position, 'wrld');
+        ser.EndGroup();
 
-        // Reset every frame
-        m_mouseDeltaRotation = ZERO;
+        if (ser.IsReading())
+        {
+            // Players that joined before us are brought to life by their first snapshot
+            m_hasServerSnapshot = true;
+            m_isAlive = true;
+        }
     }
+    else if (aspect == StateAspect)
+    {
+        ser.BeginGroup("PlayerState");
 
-    // Start with changing view rotation to the requested mouse look orientation
-    Matrix34 localTransform = IDENTITY;
-    localTransform.SetRotation33(
-        Matrix33(m_pEntity->GetWorldRotation().GetInverted()) * CCamera::CreateOrientationYPR(ypr));
+        uint8 state = static_cast<uint8>(m_snapshot.state);
+        ser.Value("state", state, 'ui8');
+        ser.Value("clip", m_snapshot.clipId, 'ui8');
+        ser.Value("facingRight", m_snapshot.facingRight, 'bool');
 
-    const float viewDistance = 4.f;
+        ser.EndGroup();
 
-    // Offset the player along the forward axis (normally back)
-    /// Also offset upwards
-    localTransform.SetTranslation(-localTransform.GetColumn1() * viewDistance);
+        // The local player predicts its own state, only remote players follow the server
+        if (ser.IsReading() && !m_isLocalPlayer && !gEnv->bServer)
+        {
+            m_snapshot.state = static_cast<EPlayerState>(state);
+            m_state = m_snapshot.state;
+            m_pSpriteFlipbookComponent->SetFacing(m_snapshot.facingRight);
+            PlayClip(m_snapshot.clipId);
+        }
+    }
 
-    m_pCameraComponent->SetTransformMatrix(localTransform);
-    m_pAudioListenerComponent->SetOffset(localTransform.GetTranslation());
+    return true;
 }
 
-void CPlayerComponent::HandleInputFlagChange(const CEnumFlags<EInputFlag> flags,
-                                             const CEnumFlags<EActionActivationMode> activationMode,
-                                             const EInputFlagType type)
+CPlayerComponent::SPlayerSnapshot CPlayerComponent::CaptureSnapshot() const
 {
-    switch (type)
+    const Vec3 position = m_pEntity->GetWorldPos();
+
+    SPlayerSnapshot snapshot;
+    snapshot.position = Vec3(
+        floor_tpl(position.x / kPositionQuantum + 0.5f) * kPositionQuantum,
+        floor_tpl(position.y / kPositionQuantum + 0.5f) * kPositionQuantum,
+        floor_tpl(position.z / kPositionQuantum + 0.5f) * kPositionQuantum);
+    snapshot.state = m_state;
+    snapshot.clipId = m_currentClipId;
+    snapshot.facingRight = m_pSpriteFlipbookComponent->IsFacingRight();
+    return snapshot;
+}
+
+void CPlayerComponent::UpdateReplication(float frameTime)
+{
+    m_statsWindowTime += frameTime;
+    if (m_statsWindowTime >= 1.f)
     {
-    case EInputFlagType::Hold:
+        if (g_gameCVars.pl_logReplicationStats)
         {
-            if (activationMode == eAAM_OnRelease)
+            // Bandwidth is measured by the channel of the owning client and covers all of its traffic.
+            // The host player has no channel, only its update rates are known.
+            const INetChannel* pChannel = gEnv->pGameFramework->GetNetChannel(m_pEntity->GetNetEntity()->GetChannelId());
+            if (pChannel)
             {
-                m_inputFlags &= ~flags;
+                const INetChannel::SStatistics channelStats = pChannel->GetStatistics();
+                CryLogAlways("[Replication] %s: %.1f movement/s, %.1f state/s, channel %.1f up / %.1f down (as reported by the net channel)",
+                    m_pEntity->GetName(),
+                    m_statsWindowMovementUpdates / m_statsWindowTime,
+                    m_statsWindowStateUpdates / m_statsWindowTime,
+                    channelStats.bandwidthUp,
+                    channelStats.bandwidthDown);
             }
             else
             {
-                m_inputFlags |= flags;
-            }
-        }
-        break;
-    case EInputFlagType::Toggle:
-        {
-            if (activationMode == eAAM_OnRelease)
-            {
-                // Toggle the bit(s)
-                m_inputFlags ^= flags;
+                CryLogAlways("[Replication] %s: %.1f movement/s, %.1f state/s, no client channel",
+                    m_pEntity->GetName(),
+                    m_statsWindowMovementUpdates / m_statsWindowTime,
+                    m_statsWindowStateUpdates / m_statsWindowTime);
             }
         }
-        break;
+
+        m_statsWindowTime = 0.f;
+        m_statsWindowMovementUpdates = 0;
+        m_statsWindowStateUpdates = 0;
+    }
+
+    const float snapshotInterval = 1.f / max(g_gameCVars.pl_snapshotRate, 1.f);
+
+    m_snapshotTimer += frameTime;
+    if (m_snapshotTimer < snapshotInterval)
+        return;
+
+    // Don't try to catch up after a hitch, one snapshot always carries the latest state
+    m_snapshotTimer = fmodf(m_snapshotTimer, snapshotInterval);
+
+    const SPlayerSnapshot snapshot = CaptureSnapshot();
+
+    // Only the aspects whose quantized values changed are marked dirty, unchanged ones are not resent
+    NetworkAspectType dirtyAspects = 0;
+    if (snapshot.position != m_snapshot.position)
+    {
+        dirtyAspects |= MovementAspect;
+        ++m_statsWindowMovementUpdates;
+    }
+    if (snapshot.state != m_snapshot.state || snapshot.clipId != m_snapshot.clipId || snapshot.facingRight != m_snapshot.facingRight)
+    {
+        dirtyAspects |= StateAspect;
+        ++m_statsWindowStateUpdates;
+    }
+
+    m_snapshot = snapshot;
+
+    if (dirtyAspects != 0)
+    {
+        NetMarkAspectsDirty(dirtyAspects);
+    }
+}
+
+void CPlayerComponent::ApplyServerPosition(float frameTime)
+{
+    if (!m_hasServerSnapshot)
+        return;
+
+    const Vec3 currentPosition = m_pEntity->GetWorldPos();
+    const Vec3 error = m_snapshot.position - currentPosition;
+    const float errorLength = error.GetLength();
+
+    // The predicted local player keeps its own position unless it drifted away from the server
+    if (m_isLocalPlayer && errorLength <= g_gameCVars.pl_predictionTolerance)
+        return;
+
+    if (errorLength >= g_gameCVars.pl_predictionSnapDistance)
+    {
+        m_pEntity->SetPos(m_snapshot.position);
+        return;
     }
+
+    const float blend = min(g_gameCVars.pl_correctionRate * frameTime, 1.f);
+    m_pEntity->SetPos(currentPosition + error * blend);
+}
+
+void CPlayerComponent::HandleInputFlagChange(const CEnumFlags<EInputFlag> flags,
+                                             const CEnumFlags<EActionActivationMode> activationMode)
+{
+    if (activationMode == eAAM_OnRelease)
+    {
+        m_inputFlags &= ~flags;
+    }
+    else
+    {
+        m_inputFlags |= flags;
+    }
+
+    // Input is sent from the local client to the server
+    NetMarkAspectsDirty(InputAspect);
+}
+
+void CPlayerComponent::HandleActionPress(SActionPresses& presses, const CEnumFlags<EActionActivationMode> activationMode)
+{
+    if (activationMode != eAAM_OnPress)
+        return;
+
+    // Wraps around, only the difference to the last processed count matters
+    ++presses.count;
+
+    // Input is sent from the local client to the server
+    NetMarkAspectsDirty(InputAspect);
 }
@@ -14,28 +14,37 @@
 
 #include "Schematyc/FFlipbookAnim.h"
 #include "Schematyc/SpriteFlipbookComponent.h"
+#include "Camera/CameraRig.h"
 
 ////////////////////////////////////////////////////////
 // Represents a player participating in gameplay
 ////////////////////////////////////////////////////////
 class CPlayerComponent final : public IEntityComponent
 {
-	enum class EInputFlagType
-	{
-		Hold = 0,
-		Toggle
-	};
-
 	enum class EInputFlag : uint8
 	{
 		MoveLeft = 1 << 0,
 		MoveRight = 1 << 1,
 		MoveForward = 1 << 2,
-		MoveBack = 1 << 3,
-		Jump = 1 << 4
+		MoveBack = 1 << 3
+	};
+
+	// Presses of a one-shot action, replicated as a wrapping counter so that several presses between two sends are not lost
+	struct SActionPresses
+	{
+		uint8 count = 0;
+		uint8 processedCount = 0;
+
+		// Returns true when the action was pressed since the last call
+		bool Consume()
+		{
+			const bool pressed = count != processedCount;
+			processedCount = count;
+			return pressed;
+		}
 	};
 
-	enum class EPlayerState
+	enum class EPlayerState : uint8
 	{
 		Idle,
 		Moving,
@@ -44,8 +53,35 @@ class CPlayerComponent final : public IEntityComponent
 		Attacking
 	};
 
+	// Quantized player state as last captured for replication
+	struct SPlayerSnapshot
+	{
+		Vec3 position = ZERO;
+		EPlayerState state = EPlayerState::Idle;
+		uint8 clipId = 0;
+		bool facingRight = true;
+	};
+
+	struct SPlayerClip
+	{
+		uint8 id;
+		FFlipbookAnim anim;
+	};
+
+	static const SPlayerClip s_clips[];
+
+	// Sent by the local client to the server
+	static constexpr EEntityAspects InputAspect = eEA_GameClientD;
+	// Sent by the server to all clients. Aspects are dirty-tracked: an aspect is only marked for
+	// sending when its quantized values changed, and is then serialized in full.
+	static constexpr EEntityAspects MovementAspect = eEA_GameServerA;
+	static constexpr EEntityAspects StateAspect = eEA_GameServerB;
+
+	// Resolution used when deciding whether the position changed since the last snapshot
+	static constexpr float kPositionQuantum = 1.f / 64.f;
+
 public:
-	CPlayerComponent();
+	CPlayerComponent() = default;
 	virtual ~CPlayerComponent() = default;
 
 	// IEntityComponent
@@ -53,6 +89,13 @@ public:
 
 	virtual Cry::Entity::EventFlags GetEventMask() const override;
 	virtual void ProcessEvent(const SEntityEvent& event) override;
+
+	virtual bool NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int flags) override;
+	virtual NetworkAspectType GetNetSerializeAspectMask() const override { return InputAspect | MovementAspect | StateAspect; }
+	// ~IEntityComponent
+
+	// Called on the server when the owning client is connected and ready for gameplay
+	void OnReadyForGameplayOnServer();
 	
 	// Reflect type to set a unique identifier for this component
 	static void ReflectType(Schematyc::CTypeDesc<CPlayerComponent>& desc)
@@ -66,13 +109,37 @@ protected:
 	void UpdateMovementRequest(float frameTime);
 	void UpdatePlayerState(float frameTime);
 	void UpdateCamera(float frameTime);
+	void UpdateReplication(float frameTime);
+	void ApplyServerPosition(float frameTime);
 
-	void HandleInputFlagChange(CEnumFlags<EInputFlag> flags, CEnumFlags<EActionActivationMode> activationMode, EInputFlagType type = EInputFlagType::Hold);
+	// Handles the actions that are sent as press counters, jump and attack
+	void ProcessActionInputs();
+
+	SPlayerSnapshot CaptureSnapshot() const;
+	static const FFlipbookAnim* FindClip(uint8 clipId);
+	void PlayClip(uint8 clipId);
+
+	void HandleInputFlagChange(CEnumFlags<EInputFlag> flags, CEnumFlags<EActionActivationMode> activationMode);
+	void HandleActionPress(SActionPresses& presses, CEnumFlags<EActionActivationMode> activationMode);
 
 	// Called when this entity becomes the local player, to create client specific setup such as the Camera
 	void InitializeLocalPlayer();
+	void RegisterInputActions();
 	
 	void EnterState(EPlayerState newState);
+	void HandleAnimationEvent(const SFlipbookEvent& animEvent);
+
+	static uint8 GetClipIdForState(EPlayerState state)
+	{
+		switch (state) {
+		case EPlayerState::Idle: return 1;
+		case EPlayerState::Moving: return 2;
+		case EPlayerState::Jumping: return 4;
+		case EPlayerState::Falling: return 5;
+		case EPlayerState::Attacking: return 6;
+		default: return 1;
+		}
+	}
 
 	const char* GetPlayerStateName() const
 	{
@@ -88,6 +155,7 @@ protected:
 	
 protected:
 	bool m_isAlive = false;
+	bool m_isLocalPlayer = false;
 
 	Cry::DefaultComponents::CCameraComponent* m_pCameraComponent = nullptr;
 	Cry::DefaultComponents::CCharacterControllerComponent* m_pCharacterController = nullptr;
@@ -97,12 +165,29 @@ protected:
 	
 
 	CEnumFlags<EInputFlag> m_inputFlags;
+	SActionPresses m_jumpPresses;
+	SActionPresses m_attackPresses;
 	Vec2 m_mouseDeltaRotation = ZERO;
 	// Should translate to head orientation in the future
 	Quat m_lookOrientation = IDENTITY;
+	CCameraRig m_cameraRig;
 
-	std::unordered_map<int, FFlipbookAnim> m_animations;
 
 	EPlayerState m_state = EPlayerState::Idle;
 	float m_stateTime = 0.f;
+	// Set by the ClipEnd event of the clip played for the current state
+	bool m_stateClipFinished = false;
+	// Set when a jump was applied, until the jump clip starts or we land
+	bool m_jumpStarted = false;
+	uint8 m_currentClipId = 0;
+
+	// Server: last snapshot marked for sending. Client: last snapshot received from the server
+	SPlayerSnapshot m_snapshot;
+	bool m_hasServerSnapshot = false;
+	float m_snapshotTimer = 0.f;
+
+	// Server side replication statistics, reset every second
+	float m_statsWindowTime = 0.f;
+	uint32 m_statsWindowMovementUpdates = 0;
+	uint32 m_statsWindowStateUpdates = 0;
 };
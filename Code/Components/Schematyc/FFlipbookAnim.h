@@ -1,16 +1,86 @@
 ﻿#pragma once
 
+enum class EFlipbookEvent : uint8
+{
+    Hit,
+    Footstep,
+    // Emitted when the last frame finishes, on every wrap for looping clips
+    ClipEnd
+};
+
+// Event placed on a frame of a clip, relative to startFrame
+struct SFlipbookEventMarker
+{
+    int frame;
+    EFlipbookEvent type;
+};
+
+// Event emitted by the flipbook when playback enters a marked frame
+struct SFlipbookEvent
+{
+    // Name of the clip that emitted it, events of a replaced clip can still be in the queue
+    const char* clip;
+    int frame;
+    EFlipbookEvent type;
+};
+
+// Plain data so clips can live in static tables and be copied without allocating
 struct FFlipbookAnim
 {
-    string name;
+    // Not owned, expected to point at a string literal
+    const char* name;
     int startFrame;
     int endFrame;
     int row;
     float fps;
     bool loop;
+    // Optional, not owned
+    const SFlipbookEventMarker* markers;
+    int markerCount;
 
     bool operator ==(const FFlipbookAnim& other) const
     {
-       return name == other.name;
+       return IsClip(other.name);
+    }
+
+    bool IsClip(const char* szName) const
+    {
+        return name == szName || (name && szName && strcmp(name, szName) == 0);
+    }
+
+    int GetFrameCount() const
+    {
+        return endFrame - startFrame + 1;
+    }
+
+    // Number of frame boundaries crossed after playing for the given time, unwrapped
+    int GetTickAt(float elapsed) const
+    {
+        return fps > 0.f ? int(elapsed / (1.f / fps)) : 0;
+    }
+
+    // Frame shown after playing for the given time, relative to startFrame
+    int GetFrameAt(float elapsed) const
+    {
+        if (fps <= 0.f)
+        {
+            return 0;
+        }
+
+        const int frameCount = GetFrameCount();
+        const float frameDuration = 1.f / fps;
+
+        int currentFrame = int(elapsed / frameDuration);
+
+        if (!loop && currentFrame >= frameCount)
+        {
+            currentFrame = frameCount - 1; // fix on last frame
+        }
+        else if (loop)
+        {
+            currentFrame %= frameCount;
+        }
+
+        return currentFrame;
     }
 };
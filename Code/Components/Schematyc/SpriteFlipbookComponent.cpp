@@ -1,6 +1,10 @@
 ﻿#include "StdAfx.h"
 
 #include "SpriteFlipbookComponent.h"
+#include "Sprites/SpriteHullLibrary.h"
+#include "Sprites/SpriteMaterialPool.h"
+#include "Sprites/SpriteRenderQueue.h"
+#include "Sprites/SpriteSheetLibrary.h"
 
 #include <CrySchematyc/Env/Elements/EnvComponent.h>
 #include <CryRenderer/IRenderer.h>
@@ -8,6 +12,8 @@
 #include <CryCore/StaticInstanceList.h>
 #include <CrySchematyc/Env/IEnvRegistrar.h>
 
+#include <limits>
+
 namespace
 {
     static void RegisterSpriteFlipbookComponent(Schematyc::IEnvRegistrar& registrar)
@@ -28,18 +34,24 @@ void CSpriteFlipbookComponent::Initialize()
         GetOrMakeEntitySlotId(),
         "%ENGINE%/EngineAssets/Objects/primitive_plane.cgf"
     );
+    m_pQuadStatObj = m_pEntity->GetStatObj(m_slotId);
 
-    m_pEntity->SetSlotLocalTM(
-        m_slotId,
-        Matrix34::Create(
-            m_localScale,
-            Quat::CreateRotationX(DEG2RAD(90.f)),
-            Vec3(0.0f, 0.0f, 0.5f)
-        )
-    );
+    UpdateSlotTransform();
+    ApplySortLayer();
 
     SetType(Cry::DefaultComponents::EMeshType::Render);
     ApplyBaseMeshProperties();
+
+    CSpriteRenderQueue::Get().Register(this);
+}
+
+void CSpriteFlipbookComponent::OnShutDown()
+{
+    CSpriteRenderQueue::Get().Unregister(this);
+
+    CSpriteMaterialPool::Get().Release(m_pAnimatedMaterial);
+    m_pAnimatedMaterial = nullptr;
+    m_pSourceMaterial = nullptr;
 }
 
 Cry::Entity::EventFlags CSpriteFlipbookComponent::GetEventMask() const
@@ -55,14 +67,8 @@ void CSpriteFlipbookComponent::ProcessEvent(const SEntityEvent& event)
     {
     case Cry::Entity::EEvent::EditorPropertyChanged:
         {
-            m_pEntity->SetSlotLocalTM(
-                m_slotId,
-                Matrix34::Create(
-                    m_localScale,
-                    Quat::CreateRotationX(DEG2RAD(90.f)),
-                    Vec3(0.0f, 0.0f, 0.5f)
-                )
-            );
+            UpdateSlotTransform();
+            ApplySortLayer();
             LoadMaterial();
         }
         break;
@@ -80,78 +86,250 @@ void CSpriteFlipbookComponent::ProcessEvent(const SEntityEvent& event)
 }
 
 void CSpriteFlipbookComponent::SetFacing(bool facingRight)
+{
+    if (m_facingRight == facingRight)
+    {
+        return;
+    }
+
+    m_facingRight = facingRight;
+    UpdateSlotTransform();
+}
+
+void CSpriteFlipbookComponent::SetSortLayer(const int layer)
+{
+    m_sortLayer = layer;
+    ApplySortLayer();
+}
+
+void CSpriteFlipbookComponent::ApplySortLayer()
+{
+    // The renderer compares sort priority before distance, so layers hold at any depth
+    if (IRenderNode* pRenderNode = m_pEntity->GetSlotRenderNode(m_slotId))
+    {
+        pRenderNode->SetSortPriority(GetSortLayer());
+    }
+}
+
+void CSpriteFlipbookComponent::SetSortOffset(const Vec3& worldOffset)
+{
+    // The slot transform is relative to the entity, including its rotation and scale. Without shear the
+    // axes of the world matrix are orthogonal, so projecting onto each axis inverts it without a full inverse.
+    const Matrix34& worldTM = m_pEntity->GetWorldTM();
+    const Vec3 axisX = worldTM.GetColumn0();
+    const Vec3 axisY = worldTM.GetColumn1();
+    const Vec3 axisZ = worldTM.GetColumn2();
+    const Vec3 localOffset(
+        axisX.Dot(worldOffset) / axisX.GetLengthSquared(),
+        axisY.Dot(worldOffset) / axisY.GetLengthSquared(),
+        axisZ.Dot(worldOffset) / axisZ.GetLengthSquared());
+    if (localOffset.IsEquivalent(m_sortOffset, 1e-6f))
+    {
+        return;
+    }
+
+    m_sortOffset = localOffset;
+    UpdateSlotTransform();
+}
+
+void CSpriteFlipbookComponent::UpdateSlotTransform()
 {
     Quat base = Quat::CreateRotationX(DEG2RAD(90.f));
-    Quat flipY = Quat::CreateRotationZ(facingRight ? 0.f : DEG2RAD(180.f));
+    Quat flipY = Quat::CreateRotationZ(m_facingRight ? 0.f : DEG2RAD(180.f));
 
     Matrix34 tm = Matrix34::Create(
         m_localScale,
         flipY * base,
-        Vec3(0.f, 0.f, 0.5f) // offset
+        Vec3(0.f, 0.f, 0.5f) + m_sortOffset // offset
     );
     m_pEntity->SetSlotLocalTM(m_slotId, tm);
 }
 
-void CSpriteFlipbookComponent::Play(const FFlipbookAnim& anim)
+void CSpriteFlipbookComponent::Play(const FFlipbookAnim& requestedAnim)
 {
+    const FFlipbookAnim* pSheetClip = m_pSpriteSheet ? m_pSpriteSheet->FindClip(requestedAnim.name) : nullptr;
+    const FFlipbookAnim& anim = pSheetClip ? *pSheetClip : requestedAnim;
+
     if (m_currentAnimationData == anim)
     {
         return;
     }
 
     m_elapsed = 0.f;
+    m_eventTick = -1;
     m_currentRow = anim.row;
     m_currentFrame = anim.startFrame;
     m_currentAnimationData = anim;
+
+    // An update replays at most one cycle, which emits every marker and one ClipEnd at most once
+    m_events.reserve(anim.markerCount + 1);
 }
 
 void CSpriteFlipbookComponent::Update(const float frameTime)
 {
+    m_events.clear();
+
+    // Playback and its events run without a material too, gameplay depends on them on dedicated servers
+    if (m_currentAnimationData.fps > 0.f)
+    {
+        m_elapsed += frameTime;
+
+        m_currentFrame = m_currentAnimationData.startFrame + m_currentAnimationData.GetFrameAt(m_elapsed);
+        EmitEvents(m_currentAnimationData.GetTickAt(m_elapsed));
+    }
+
+    if (m_pSpriteSheet)
+    {
+        ApplySheetFrame(m_currentFrame);
+        return;
+    }
+
     if (m_columns == -1 || m_rows == -1)
     {
         return;
     }
 
-    if (m_currentAnimationData.fps > 0.f)
+    ApplyFrameGeometry(m_currentFrame % m_columns, m_currentRow);
+}
+
+void CSpriteFlipbookComponent::EmitEvents(int tick)
+{
+    const FFlipbookAnim& anim = m_currentAnimationData;
+    const int frameCount = anim.GetFrameCount();
+    if (frameCount <= 0)
     {
-        m_elapsed += frameTime;
+        return;
+    }
 
-        const int frameCount = m_currentAnimationData.endFrame - m_currentAnimationData.startFrame + 1;
-        const float frameDuration = 1.f / m_currentAnimationData.fps;
+    int firstTick = m_eventTick + 1;
+    if (anim.loop)
+    {
+        // Replaying more than one full cycle after a long hitch would only repeat the same events
+        firstTick = max(firstTick, tick - frameCount + 1);
+    }
+    else
+    {
+        // Tick frameCount is where the last frame finishes, nothing follows it
+        tick = min(tick, frameCount);
+    }
 
-        int currentFrame = int(m_elapsed / frameDuration);
+    for (int currentTick = firstTick; currentTick <= tick; ++currentTick)
+    {
+        if (currentTick > 0 && currentTick % frameCount == 0)
+        {
+            m_events.push_back({ anim.name, frameCount - 1, EFlipbookEvent::ClipEnd });
+        }
 
-        if (!m_currentAnimationData.loop && currentFrame >= frameCount)
+        if (!anim.loop && currentTick >= frameCount)
         {
-            currentFrame = frameCount - 1; // fix on last frame
+            break;
         }
-        else if (m_currentAnimationData.loop)
+
+        const int frame = currentTick % frameCount;
+        for (int i = 0; i < anim.markerCount; ++i)
         {
-            currentFrame %= frameCount;
+            if (anim.markers[i].frame == frame)
+            {
+                m_events.push_back({ anim.name, frame, anim.markers[i].type });
+            }
         }
+    }
+
+    m_eventTick = max(m_eventTick, tick);
+}
 
-        m_currentFrame = m_currentAnimationData.startFrame + currentFrame;
+void CSpriteFlipbookComponent::ApplyFrameGeometry(int frameX, int frameY)
+{
+    if (!m_pHullSet)
+    {
+        return;
     }
 
-    ApplyUVOffset( m_currentFrame % m_columns, m_currentRow);
+    const int frame = frameY * m_columns + frameX;
+    if (frame == m_geometryFrame)
+    {
+        return;
+    }
+
+    m_geometryFrame = frame;
+
+    IStatObj* pFrameStatObj = m_pHullSet->GetFrame(frameX, frameY);
+    m_pEntity->SetStatObj(pFrameStatObj ? pFrameStatObj : m_pQuadStatObj.get(), m_slotId, false);
 }
 
-void CSpriteFlipbookComponent::ApplyUVOffset(int frameX, int frameY)
+void CSpriteFlipbookComponent::ApplySheetFrame(const int sequenceIndex)
 {
-    if (!m_pAnimatedMaterial)
+    if (sequenceIndex == m_geometryFrame)
     {
         return;
     }
 
-    if (m_pFrameXParam)
-        m_pFrameXParam->m_Value.m_Float = static_cast<float>(frameX);
+    m_geometryFrame = sequenceIndex;
 
-    if (m_pFrameYParam)
-        m_pFrameYParam->m_Value.m_Float = static_cast<float>(frameY);
+    IStatObj* pFrameStatObj = m_pSpriteSheet->GetSequenceFrame(sequenceIndex);
+    m_pEntity->SetStatObj(pFrameStatObj ? pFrameStatObj : m_pQuadStatObj.get(), m_slotId, false);
+}
 
-    m_pAnimatedMaterial->GetShaderItem().m_pShaderResources->UpdateConstants(
-        m_pAnimatedMaterial->GetShaderItem().m_pShader
-    );
+void CSpriteFlipbookComponent::SetPaletteRow(const int paletteRow)
+{
+    if (m_paletteRow == paletteRow)
+    {
+        return;
+    }
+
+    m_paletteRow = paletteRow;
+    ApplyPaletteRow();
+}
+
+void CSpriteFlipbookComponent::ApplyPaletteRow()
+{
+    if (!m_pSourceMaterial)
+    {
+        return;
+    }
+
+    // Full-colour atlases share a single variant whatever the row
+    int paletteRow = 0;
+    if (m_hasPalette)
+    {
+        // Negative rows are never valid, the upper bound is only known when the atlas reports its row count
+        paletteRow = m_paletteRow;
+        const int lastPaletteRow = m_paletteRows > 0 ? m_paletteRows - 1 : std::numeric_limits<int>::max();
+        if (paletteRow < 0 || paletteRow > lastPaletteRow)
+        {
+            CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Palette row %d is out of range for %s!", paletteRow, m_pEntity->GetName());
+            paletteRow = crymath::clamp(paletteRow, 0, lastPaletteRow);
+        }
+    }
+
+    if (m_pAnimatedMaterial && paletteRow == m_materialPaletteRow)
+    {
+        return;
+    }
+
+    // Sprites showing the same atlas in the same colours share one clone
+    CSpriteMaterialPool& pool = CSpriteMaterialPool::Get();
+    pool.Release(m_pAnimatedMaterial);
+    m_pAnimatedMaterial = pool.Acquire(m_pSourceMaterial, paletteRow);
+    m_materialPaletteRow = paletteRow;
+
+    // Packed atlases place every frame through its own mesh, the material samples the whole texture.
+    // Every user of the variant shows the same sheet, so this only ever writes the same values.
+    if (m_pSpriteSheet)
+    {
+        SShaderItem& shaderItem = m_pAnimatedMaterial->GetShaderItem();
+        for (SShaderParam& param : shaderItem.m_pShaderResources->GetParameters())
+        {
+            if (strcmp(param.m_Name, "TilesX") == 0 || strcmp(param.m_Name, "TilesY") == 0)
+            {
+                param.m_Value.m_Float = 1.f;
+            }
+        }
+        shaderItem.m_pShaderResources->UpdateConstants(shaderItem.m_pShader);
+    }
+
+    m_pEntity->SetMaterial(m_pAnimatedMaterial);
+    ApplySortLayer();
 }
 
 void CSpriteFlipbookComponent::LoadMaterial()
@@ -175,19 +353,27 @@ void CSpriteFlipbookComponent::LoadMaterial()
         return;
     }
 
-    if (m_pAnimatedMaterial && pOriginalMaterial->GetName() == m_pAnimatedMaterial->GetName())
+    // Already loaded, usually by the level precache before gameplay started
+    if (m_pSourceMaterial == pOriginalMaterial)
     {
-        CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Animated Material already loaded %s!", m_pAnimatedMaterial->GetName());
+        // The palette row may have been edited since
+        ApplyPaletteRow();
         return;
     }
 
-    m_pAnimatedMaterial = gEnv->p3DEngine->GetMaterialManager()->CloneMaterial(pOriginalMaterial);
-    m_pEntity->SetMaterial(m_pAnimatedMaterial);
+    // The variant of the previous atlas is replaced below
+    CSpriteMaterialPool::Get().Release(m_pAnimatedMaterial);
+    m_pAnimatedMaterial = nullptr;
+    m_pSourceMaterial = pOriginalMaterial;
+    m_atlasId = CSpriteRenderQueue::Get().GetAtlasId(m_materialPath.value);
+
+    // The layout is read from the source, variants may have their grid reduced for packed atlases
+    m_columns = -1;
+    m_rows = -1;
+    m_paletteRows = -1;
+    m_hasPalette = false;
 
-    SShaderItem& shaderItem = m_pAnimatedMaterial->GetShaderItem();
-    IRenderShaderResources* pResources = shaderItem.m_pShaderResources;
-    
-    for (SShaderParam& param : pResources->GetParameters())
+    for (const SShaderParam& param : pOriginalMaterial->GetShaderItem().m_pShaderResources->GetParameters())
     {
         if (strcmp(param.m_Name, "TilesX") == 0)
         {
@@ -197,18 +383,50 @@ void CSpriteFlipbookComponent::LoadMaterial()
         {
             m_rows = (int)param.m_Value.m_Float;
         }
-        if (strcmp(param.m_Name, "FrameX") == 0)
+        // Indexed atlases store palette indices, the colour comes from one row of the palette texture
+        if (strcmp(param.m_Name, "PaletteRows") == 0)
         {
-            m_pFrameXParam = &param; 
+            m_paletteRows = (int)param.m_Value.m_Float;
         }
-        if (strcmp(param.m_Name, "FrameY") == 0)
+        if (strcmp(param.m_Name, "PaletteRow") == 0)
         {
-            m_pFrameYParam = &param; 
+            m_hasPalette = true;
         }
     }
 
+    m_geometryFrame = -1;
+    m_pHullSet = nullptr;
+    m_pSpriteSheet = CSpriteSheetLibrary::Get().FindOrLoad(m_materialPath.value);
+
+    ApplyPaletteRow();
+
+    if (m_pSpriteSheet)
+    {
+        m_columns = 1;
+        m_rows = 1;
+
+        // Switch a clip that started before the sheet was loaded over to its packed version
+        if (const FFlipbookAnim* pSheetClip = m_pSpriteSheet->FindClip(m_currentAnimationData.name))
+        {
+            m_currentAnimationData = *pSheetClip;
+            m_events.reserve(pSheetClip->markerCount + 1);
+            m_currentRow = 0;
+            m_currentFrame = pSheetClip->startFrame + pSheetClip->GetFrameAt(m_elapsed);
+        }
+        return;
+    }
+
     if (m_columns == -1 || m_rows == -1)
     {
         CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Couldn't find any tiles in the Sprite FlipBook");
+        return;
+    }
+
+    // Every frame has its own mesh, alpha-trimmed when the atlas has hulls
+    m_pHullSet = CSpriteHullLibrary::Get().FindOrLoad(m_materialPath.value, m_columns, m_rows);
+
+    if (!m_pHullSet && m_pQuadStatObj)
+    {
+        m_pEntity->SetStatObj(m_pQuadStatObj, m_slotId, false);
     }
 }
@@ -5,6 +5,9 @@
 
 #include "FFlipbookAnim.h"
 
+struct SSpriteHullSet;
+struct SSpriteSheet;
+
 class CSpriteFlipbookComponent  final : public Cry::DefaultComponents::CBaseMeshComponent
 {
 public:
@@ -13,6 +16,7 @@ public:
 
     // IEntityComponent
     virtual void Initialize() override;
+    virtual void OnShutDown() override;
 
     virtual Cry::Entity::EventFlags GetEventMask() const override;
     virtual void ProcessEvent(const SEntityEvent& event) override;
@@ -29,33 +33,83 @@ public:
         desc.SetDescription("2D Flipbook animation component");
         desc.AddMember(&CSpriteFlipbookComponent::m_materialPath, 'mat', "Material", "Sprite Material", "Specifies the override material for the selected object", "");
         desc.AddMember(&CSpriteFlipbookComponent::m_localScale, 'scal', "LocalScale", "Local Scale", "Per-component scale override", Vec3(1.0f));
+        desc.AddMember(&CSpriteFlipbookComponent::m_paletteRow, 'pal', "PaletteRow", "Palette Row", "Row of the palette texture used to colour an indexed atlas", 0);
+        desc.AddMember(&CSpriteFlipbookComponent::m_sortLayer, 'layr', "SortLayer", "Sort Layer", "Sprites on higher layers draw on top (0-255)", 0);
+        desc.AddMember(&CSpriteFlipbookComponent::m_sortOrder, 'sord', "SortOrder", "Sort Order", "Tie-break between sprites of the same layer and depth (0-65535)", 0);
     }
 
     void LoadMaterial();
+    const char* GetMaterialPath() const { return m_materialPath.value.c_str(); }
     
+    // Clips packed into the sprite sheet of the atlas replace the given clip when they have the same name
     void Play(const FFlipbookAnim& anim);
+    const FFlipbookAnim& GetCurrentClip() const { return m_currentAnimationData; }
+
+    // Events emitted by the last flipbook update, in playback order. Frames skipped during
+    // a hitch still emit theirs. The queue is replaced on every update, so a consumer that
+    // reads it once per frame sees every event exactly once.
+    const std::vector<SFlipbookEvent>& GetEvents() const { return m_events; }
     void SetFacing(bool facingRight);
+    bool IsFacingRight() const { return m_facingRight; }
+
+    // Selects the colour variant of an indexed atlas, ignored by full-colour atlases
+    void SetPaletteRow(int paletteRow);
+    int GetPaletteRow() const { return m_paletteRow; }
+
+    // Sort key inputs, resolved every frame by CSpriteRenderQueue
+    void SetSortLayer(int layer);
+    void SetSortOrder(int order) { m_sortOrder = order; }
+    uint8 GetSortLayer() const { return static_cast<uint8>(crymath::clamp(m_sortLayer, 0, 255)); }
+    uint16 GetSortOrder() const { return static_cast<uint16>(crymath::clamp(m_sortOrder, 0, 65535)); }
+    uint16 GetAtlasId() const { return m_atlasId; }
+
+    // World space offset along the view axis that enforces the resolved draw order
+    void SetSortOffset(const Vec3& worldOffset);
 private:
     void Update(float frameTime);
-    void ApplyUVOffset(int frameX, int frameY);
+    void EmitEvents(int tick);
+    void ApplyPaletteRow();
+    void ApplyFrameGeometry(int frameX, int frameY);
+    void ApplySheetFrame(int sequenceIndex);
+    void UpdateSlotTransform();
+    void ApplySortLayer();
 
 
     int m_slotId = -1;
     int m_columns = -1;
     int m_rows = -1;
+    int m_paletteRows = -1;
+    bool m_hasPalette = false;
 
     float m_elapsed = 0.f;     
     int m_currentFrame = 0;
     int m_currentRow = 0;
+    bool m_facingRight = true;
 
     Vec3 m_localScale = Vec3(1.0f, 1.0f, 1.0f);
+    int m_paletteRow = 0;
+    int m_sortLayer = 0;
+    int m_sortOrder = 0;
+
+    uint16 m_atlasId = 0;
+    // Sort offset in entity space
+    Vec3 m_sortOffset = ZERO;
 
-    FFlipbookAnim m_currentAnimationData;
+    FFlipbookAnim m_currentAnimationData = { "", 0, 0, 0, 0.f, false, nullptr, 0 };
+    // Last frame boundary whose events were emitted, -1 until the first frame of the clip
+    int m_eventTick = -1;
+    std::vector<SFlipbookEvent> m_events;
 
     Schematyc::MaterialFileName m_materialPath;
-    IMaterial* m_pAnimatedMaterial = nullptr;
+    _smart_ptr<IMaterial> m_pSourceMaterial;
+    // Palette variant shared with every sprite of the atlas using the same row, owned by the material pool
+    _smart_ptr<IMaterial> m_pAnimatedMaterial;
+    int m_materialPaletteRow = -1;
 
-    // cache
-    SShaderParam* m_pFrameXParam = nullptr;
-    SShaderParam* m_pFrameYParam = nullptr;
+    // Frame meshes of a grid atlas, their texture coordinates select the tile
+    const SSpriteHullSet* m_pHullSet = nullptr;
+    // Packed atlas, every frame has its own mesh and the material grid is reduced to a single tile
+    const SSpriteSheet* m_pSpriteSheet = nullptr;
+    _smart_ptr<IStatObj> m_pQuadStatObj;
+    int m_geometryFrame = -1;
 };
@@ -0,0 +1,547 @@
+﻿#include "StdAfx.h"
+
+#include "TilemapComponent.h"
+#include "GameCVars.h"
+
+#include <CrySchematyc/Env/Elements/EnvComponent.h>
+#include <CrySchematyc/Env/IEnvRegistrar.h>
+#include <CryRenderer/IRenderer.h>
+#include <Cry3DEngine/I3DEngine.h>
+#include <Cry3DEngine/IIndexedMesh.h>
+#include <CryCore/StaticInstanceList.h>
+#include <CrySystem/File/ICryPak.h>
+
+namespace
+{
+    static void RegisterTilemapComponent(Schematyc::IEnvRegistrar& registrar)
+    {
+        Schematyc::CEnvRegistrationScope scope = registrar.Scope(IEntity::GetEntityScopeGUID());
+        {
+            Schematyc::CEnvRegistrationScope componentScope = scope.Register(
+                SCHEMATYC_MAKE_ENV_COMPONENT(CTilemapComponent));
+        }
+    }
+
+    CRY_STATIC_AUTO_REGISTER_FUNCTION(&RegisterTilemapComponent);
+}
+
+void CTilemapComponent::Initialize()
+{
+    LoadMaterial();
+    LoadTilemap();
+}
+
+Cry::Entity::EventFlags CTilemapComponent::GetEventMask() const
+{
+    return Cry::Entity::EEvent::Update |
+        Cry::Entity::EEvent::EditorPropertyChanged;
+}
+
+void CTilemapComponent::ProcessEvent(const SEntityEvent& event)
+{
+    switch (event.event)
+    {
+    case Cry::Entity::EEvent::EditorPropertyChanged:
+        {
+            LoadMaterial();
+            LoadTilemap();
+        }
+        break;
+    case Cry::Entity::EEvent::Update:
+        {
+            Update(event.fParam[0]);
+        }
+        break;
+    }
+}
+
+void CTilemapComponent::LoadMaterial()
+{
+    if (m_materialPath.value.size() <= 0)
+    {
+        return;
+    }
+
+    IMaterial* pOriginalMaterial = gEnv->p3DEngine->GetMaterialManager()->LoadMaterial(m_materialPath.value);
+    if (!pOriginalMaterial)
+    {
+        CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Failed to load material %s!", m_materialPath.value.c_str());
+        return;
+    }
+
+    // One clone for the whole map. Chunk UVs are baked in tile units, so the frame offset stays at zero
+    m_pMaterial = gEnv->p3DEngine->GetMaterialManager()->CloneMaterial(pOriginalMaterial);
+    m_pEntity->SetMaterial(m_pMaterial);
+
+    m_columns = -1;
+    m_rows = -1;
+
+    SShaderItem& shaderItem = m_pMaterial->GetShaderItem();
+    IRenderShaderResources* pResources = shaderItem.m_pShaderResources;
+
+    for (SShaderParam& param : pResources->GetParameters())
+    {
+        if (strcmp(param.m_Name, "TilesX") == 0)
+        {
+            m_columns = (int)param.m_Value.m_Float;
+        }
+        if (strcmp(param.m_Name, "TilesY") == 0)
+        {
+            m_rows = (int)param.m_Value.m_Float;
+        }
+        if (strcmp(param.m_Name, "FrameX") == 0 || strcmp(param.m_Name, "FrameY") == 0)
+        {
+            param.m_Value.m_Float = 0.f;
+        }
+    }
+
+    pResources->UpdateConstants(shaderItem.m_pShader);
+
+    if (m_columns == -1 || m_rows == -1)
+    {
+        CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Couldn't find any tiles in the Tilemap atlas %s", m_materialPath.value.c_str());
+    }
+
+    for (SChunk& chunk : m_chunks)
+    {
+        chunk.MarkDirty();
+    }
+}
+
+bool CTilemapComponent::LoadTilemap()
+{
+    if (m_tilemapPath.empty())
+    {
+        return false;
+    }
+
+    FILE* pFile = gEnv->pCryPak->FOpen(m_tilemapPath.c_str(), "rb");
+    if (!pFile)
+    {
+        CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Failed to open tilemap %s!", m_tilemapPath.c_str());
+        return false;
+    }
+
+    const size_t fileSize = gEnv->pCryPak->FGetSize(pFile);
+    string contents;
+    contents.resize(fileSize);
+    gEnv->pCryPak->FReadRaw(contents.begin(), 1, fileSize, pFile);
+    gEnv->pCryPak->FClose(pFile);
+
+    m_animatedTiles.clear();
+
+    int row = -1;
+    size_t lineStart = 0;
+    string line;
+
+    while (lineStart < contents.length())
+    {
+        size_t lineEnd = contents.find('\n', lineStart);
+        if (lineEnd == string::npos)
+            lineEnd = contents.length();
+
+        line = contents.substr(lineStart, lineEnd - lineStart);
+        line.Trim();
+        lineStart = lineEnd + 1;
+
+        const char* szLine = line.c_str();
+        int consumed = 0;
+
+        if (strncmp(szLine, "size ", 5) == 0)
+        {
+            int width = 0, height = 0;
+            if (sscanf(szLine + 5, "%d %d", &width, &height) != 2 || width <= 0 || height <= 0)
+            {
+                CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Invalid size in tilemap %s!", m_tilemapPath.c_str());
+                return false;
+            }
+
+            Resize(width, height);
+            row = height - 1;
+        }
+        else if (strncmp(szLine, "anim ", 5) == 0)
+        {
+            int tileIndex = 0;
+            FFlipbookAnim anim = { nullptr, 0, 0, 0, 0.f, true };
+            if (sscanf(szLine + 5, "%d %d %d %d %f", &tileIndex, &anim.startFrame, &anim.endFrame, &anim.row, &anim.fps) == 5)
+            {
+                // Each clip is named after its tile so clips of different tiles never compare equal
+                SAnimatedTile& animatedTile = m_animatedTiles[tileIndex];
+                cry_sprintf(animatedTile.name, "tile%d", tileIndex);
+                anim.name = animatedTile.name;
+                SetAnimatedTile(tileIndex, anim);
+            }
+        }
+        else if (strncmp(szLine, "row ", 4) == 0 && row >= 0)
+        {
+            const char* szCursor = szLine + 4;
+            int tileIndex = kEmptyTile;
+            for (int x = 0; x < m_width && sscanf(szCursor, "%d%n", &tileIndex, &consumed) == 1; ++x)
+            {
+                szCursor += consumed;
+                if (tileIndex < kEmptyTile)
+                {
+                    CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Invalid tile index %d at %d, %d in tilemap %s, leaving the cell empty", tileIndex, x, row, m_tilemapPath.c_str());
+                    tileIndex = kEmptyTile;
+                }
+                SetTile(x, row, tileIndex);
+            }
+            --row;
+        }
+    }
+
+    return true;
+}
+
+void CTilemapComponent::Resize(int width, int height)
+{
+    const int chunkSize = max(m_chunkSize, 1);
+    m_chunkSize = chunkSize;
+
+    // Reloading a map of the same size keeps the chunks and their slots, only the tiles are cleared
+    if (width != m_width || height != m_height || chunkSize != m_layoutChunkSize)
+    {
+        ReleaseChunks();
+
+        m_width = width;
+        m_height = height;
+        m_layoutChunkSize = chunkSize;
+        m_chunksX = (width + chunkSize - 1) / chunkSize;
+        m_chunksY = (height + chunkSize - 1) / chunkSize;
+
+        // Never shrinks, chunks past the current layout keep their arena storage for a later resize
+        const size_t chunkCount = size_t(m_chunksX * m_chunksY);
+        if (m_chunks.size() < chunkCount)
+        {
+            m_chunks.resize(chunkCount);
+        }
+    }
+
+    for (int chunkY = 0; chunkY < m_chunksY; ++chunkY)
+    {
+        for (int chunkX = 0; chunkX < m_chunksX; ++chunkX)
+        {
+            SChunk& chunk = m_chunks[chunkY * m_chunksX + chunkX];
+
+            // Reuses the existing arena storage whenever it is large enough
+            chunk.tiles.assign(chunkSize * chunkSize, kEmptyTile);
+            chunk.MarkDirty();
+
+            const Vec3 origin(float(chunkX * chunkSize) * m_tileSize, float(chunkY * chunkSize) * m_tileSize, 0.f);
+            chunk.localBounds = AABB(origin, origin + Vec3(float(chunkSize) * m_tileSize, float(chunkSize) * m_tileSize, 0.01f));
+        }
+    }
+}
+
+CTilemapComponent::SChunk* CTilemapComponent::GetChunk(int x, int y)
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+    {
+        return nullptr;
+    }
+
+    return &m_chunks[(y / m_layoutChunkSize) * m_chunksX + x / m_layoutChunkSize];
+}
+
+void CTilemapComponent::SetTile(int x, int y, int tileIndex)
+{
+    SChunk* pChunk = GetChunk(x, y);
+    if (!pChunk)
+    {
+        return;
+    }
+
+    int& tile = pChunk->tiles[(y % m_layoutChunkSize) * m_layoutChunkSize + x % m_layoutChunkSize];
+    if (tile == tileIndex)
+    {
+        return;
+    }
+
+    // Only the meshes drawing the old and the new tile are rebuilt
+    if (tile != kEmptyTile)
+    {
+        (IsAnimatedTile(tile) ? pChunk->animatedMesh : pChunk->staticMesh).dirty = true;
+    }
+    if (tileIndex != kEmptyTile)
+    {
+        (IsAnimatedTile(tileIndex) ? pChunk->animatedMesh : pChunk->staticMesh).dirty = true;
+    }
+
+    tile = tileIndex;
+}
+
+int CTilemapComponent::GetTile(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+    {
+        return kEmptyTile;
+    }
+
+    const SChunk& chunk = m_chunks[(y / m_layoutChunkSize) * m_chunksX + x / m_layoutChunkSize];
+    return chunk.tiles[(y % m_layoutChunkSize) * m_layoutChunkSize + x % m_layoutChunkSize];
+}
+
+void CTilemapComponent::SetAnimatedTile(int tileIndex, const FFlipbookAnim& anim)
+{
+    SAnimatedTile& animatedTile = m_animatedTiles[tileIndex];
+    animatedTile.anim = anim;
+    animatedTile.frame = anim.GetFrameAt(m_elapsed);
+
+    // The tile moves from the static to the animated meshes
+    for (SChunk& chunk : m_chunks)
+    {
+        chunk.MarkDirty();
+    }
+}
+
+int CTilemapComponent::GetFrameForTile(int tileIndex) const
+{
+    // Animated tiles use the same frame layout as CSpriteFlipbookComponent
+    const auto it = m_animatedTiles.find(tileIndex);
+    if (it != m_animatedTiles.end())
+    {
+        const FFlipbookAnim& anim = it->second.anim;
+        const int frame = anim.startFrame + it->second.frame;
+        return anim.row * m_columns + frame % m_columns;
+    }
+
+    return tileIndex;
+}
+
+void CTilemapComponent::Update(float frameTime)
+{
+    if (!m_pMaterial || m_columns <= 0 || m_rows <= 0)
+    {
+        return;
+    }
+
+    UpdateAnimatedTiles(frameTime);
+
+    // Only chunks in view are baked, the others keep their stale mesh until they are seen again
+    const CCamera& camera = gEnv->pSystem->GetViewCamera();
+    const Matrix34& worldTM = m_pEntity->GetWorldTM();
+
+    int chunkBuilds = 0;
+    for (int chunkY = 0; chunkY < m_chunksY; ++chunkY)
+    {
+        for (int chunkX = 0; chunkX < m_chunksX; ++chunkX)
+        {
+            SChunk& chunk = m_chunks[chunkY * m_chunksX + chunkX];
+            if (!chunk.IsDirty())
+                continue;
+
+            if (!camera.IsAABBVisible_F(AABB::CreateTransformedAABB(worldTM, chunk.localBounds)))
+                continue;
+
+            // Animated meshes only hold the animated quads and keep every clip in step, so they are never deferred
+            if (chunk.animatedMesh.dirty)
+            {
+                BuildChunk(chunk, chunkX, chunkY, true);
+            }
+            else if (chunk.animatedMesh.framesDirty)
+            {
+                UpdateChunkFrames(chunk);
+            }
+
+            if (chunk.staticMesh.dirty && chunkBuilds < g_gameCVars.tm_maxChunkBuildsPerFrame)
+            {
+                BuildChunk(chunk, chunkX, chunkY, false);
+                ++chunkBuilds;
+            }
+        }
+    }
+}
+
+void CTilemapComponent::UpdateAnimatedTiles(float frameTime)
+{
+    if (m_animatedTiles.empty())
+    {
+        return;
+    }
+
+    m_elapsed += frameTime;
+
+    bool frameChanged = false;
+    for (auto& animatedTile : m_animatedTiles)
+    {
+        const int frame = animatedTile.second.anim.GetFrameAt(m_elapsed);
+        if (frame != animatedTile.second.frame)
+        {
+            animatedTile.second.frame = frame;
+            frameChanged = true;
+        }
+    }
+
+    if (!frameChanged)
+    {
+        return;
+    }
+
+    for (SChunk& chunk : m_chunks)
+    {
+        chunk.animatedMesh.framesDirty |= chunk.hasAnimatedTiles;
+    }
+}
+
+void CTilemapComponent::BuildChunk(SChunk& chunk, int chunkX, int chunkY, bool animated)
+{
+    SChunkMesh& mesh = animated ? chunk.animatedMesh : chunk.staticMesh;
+    mesh.dirty = false;
+    mesh.framesDirty = false;
+
+    int tileCount = 0;
+    for (const int tileIndex : chunk.tiles)
+    {
+        if (tileIndex != kEmptyTile && IsAnimatedTile(tileIndex) == animated)
+        {
+            ++tileCount;
+        }
+    }
+
+    if (animated)
+    {
+        chunk.hasAnimatedTiles = tileCount != 0;
+    }
+
+    if (tileCount == 0)
+    {
+        ReleaseChunkMesh(mesh);
+        return;
+    }
+
+    // Created once per chunk and mesh, rebuilds only resize and refill its streams
+    if (!mesh.pStatObj)
+    {
+        mesh.pStatObj = gEnv->p3DEngine->CreateStatObj();
+        mesh.slotId = m_pEntity->SetStatObj(mesh.pStatObj, mesh.slotId, false);
+    }
+
+    CMesh* pMesh = mesh.pStatObj->GetIndexedMesh(true)->GetMesh();
+
+    const int vertexCount = tileCount * 4;
+    const int indexCount = tileCount * 6;
+
+    pMesh->SetVertexCount(vertexCount);
+    pMesh->SetTexCoordsAndTangentsCount(vertexCount);
+    pMesh->SetIndexCount(indexCount);
+
+    Vec3* pPositions = pMesh->GetStreamPtr<Vec3>(CMesh::POSITIONS);
+    SMeshNormal* pNormals = pMesh->GetStreamPtr<SMeshNormal>(CMesh::NORMALS);
+    SMeshTexCoord* pTexCoords = pMesh->GetStreamPtr<SMeshTexCoord>(CMesh::TEXCOORDS);
+    SMeshTangents* pTangents = pMesh->GetStreamPtr<SMeshTangents>(CMesh::TANGENTS);
+    vtx_idx* pIndices = pMesh->GetStreamPtr<vtx_idx>(CMesh::INDICES);
+
+    // Corners of a tile as (x, y) offsets, matching the order of WriteTexCoords
+    static const Vec2 corners[4] = { Vec2(0.f, 0.f), Vec2(1.f, 0.f), Vec2(1.f, 1.f), Vec2(0.f, 1.f) };
+
+    int vertex = 0;
+    int index = 0;
+    for (int localY = 0; localY < m_layoutChunkSize; ++localY)
+    {
+        for (int localX = 0; localX < m_layoutChunkSize; ++localX)
+        {
+            const int tileIndex = chunk.tiles[localY * m_layoutChunkSize + localX];
+            if (tileIndex == kEmptyTile || IsAnimatedTile(tileIndex) != animated)
+                continue;
+
+            const float tileX = float(chunkX * m_layoutChunkSize + localX);
+            const float tileY = float(chunkY * m_layoutChunkSize + localY);
+
+            for (int corner = 0; corner < 4; ++corner)
+            {
+                pPositions[vertex + corner] = Vec3((tileX + corners[corner].x) * m_tileSize, (tileY + corners[corner].y) * m_tileSize, 0.f);
+                pNormals[vertex + corner] = SMeshNormal(Vec3(0.f, 0.f, 1.f));
+                pTangents[vertex + corner] = SMeshTangents(Vec3(1.f, 0.f, 0.f), Vec3(0.f, -1.f, 0.f), Vec3(0.f, 0.f, 1.f));
+            }
+
+            pIndices[index++] = vertex + 0;
+            pIndices[index++] = vertex + 1;
+            pIndices[index++] = vertex + 2;
+            pIndices[index++] = vertex + 0;
+            pIndices[index++] = vertex + 2;
+            pIndices[index++] = vertex + 3;
+
+            vertex += 4;
+        }
+    }
+
+    SMeshSubset subset;
+    subset.nFirstIndexId = 0;
+    subset.nNumIndices = indexCount;
+    subset.nFirstVertId = 0;
+    subset.nNumVerts = vertexCount;
+    subset.nMatID = 0;
+    subset.nMatFlags = 0;
+    subset.nPhysicalizeType = PHYS_GEOM_TYPE_NONE;
+    pMesh->m_subsets.clear();
+    pMesh->m_subsets.push_back(subset);
+    pMesh->m_bbox = chunk.localBounds;
+
+    WriteTexCoords(chunk, animated, pTexCoords);
+
+    mesh.pStatObj->Invalidate(false);
+    // The atlas material may have been reloaded since the slot was created
+    m_pEntity->SetSlotMaterial(mesh.slotId, m_pMaterial);
+}
+
+void CTilemapComponent::UpdateChunkFrames(SChunk& chunk)
+{
+    SChunkMesh& mesh = chunk.animatedMesh;
+    mesh.framesDirty = false;
+
+    if (!mesh.pStatObj)
+    {
+        return;
+    }
+
+    // The quads are unchanged, only the frames they show moved on
+    CMesh* pMesh = mesh.pStatObj->GetIndexedMesh(true)->GetMesh();
+    WriteTexCoords(chunk, true, pMesh->GetStreamPtr<SMeshTexCoord>(CMesh::TEXCOORDS));
+    mesh.pStatObj->Invalidate(false);
+}
+
+void CTilemapComponent::WriteTexCoords(const SChunk& chunk, bool animated, SMeshTexCoord* pTexCoords) const
+{
+    // UVs in tile units with v down, the sprite shader maps them into the atlas
+    static const Vec2 corners[4] = { Vec2(0.f, 1.f), Vec2(1.f, 1.f), Vec2(1.f, 0.f), Vec2(0.f, 0.f) };
+
+    for (const int tileIndex : chunk.tiles)
+    {
+        if (tileIndex == kEmptyTile || IsAnimatedTile(tileIndex) != animated)
+            continue;
+
+        const int frame = GetFrameForTile(tileIndex);
+        const float frameX = float(frame % m_columns);
+        const float frameY = float(frame / m_columns);
+
+        for (const Vec2& corner : corners)
+        {
+            *pTexCoords++ = SMeshTexCoord(frameX + corner.x, frameY + corner.y);
+        }
+    }
+}
+
+void CTilemapComponent::ReleaseChunkMesh(SChunkMesh& mesh)
+{
+    if (mesh.slotId != -1)
+    {
+        m_pEntity->FreeSlot(mesh.slotId);
+        mesh.slotId = -1;
+    }
+    mesh.pStatObj = nullptr;
+}
+
+void CTilemapComponent::ReleaseChunks()
+{
+    // The chunks themselves are kept, their tile storage lives in the level arena and is reused
+    for (SChunk& chunk : m_chunks)
+    {
+        ReleaseChunkMesh(chunk.staticMesh);
+        ReleaseChunkMesh(chunk.animatedMesh);
+        chunk.hasAnimatedTiles = false;
+    }
+
+    m_chunksX = 0;
+    m_chunksY = 0;
+    m_layoutChunkSize = 0;
+}
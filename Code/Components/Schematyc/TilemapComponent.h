@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <CryEntitySystem/IEntityComponent.h>
+#include <CrySchematyc/Reflection/TypeDesc.h>
+#include <CrySchematyc/ResourceTypes.h>
+#include <CrySchematyc/Utils/SharedString.h>
+
+#include "FFlipbookAnim.h"
+#include "Memory/LevelArena.h"
+
+////////////////////////////////////////////////////////
+// Static grid of atlas tiles baked into meshes per chunk
+//
+// Tiles are loaded from a text .tilemap file:
+//   tilemap 1
+//   size <width> <height>
+//   anim <tileIndex> <startFrame> <endFrame> <row> <fps>
+//   row <index> <index> ...     (one line per row, top row first)
+// A tile index selects the atlas frame row-major, -1 leaves the cell empty.
+// Indices listed by an anim line play that looping clip instead.
+////////////////////////////////////////////////////////
+class CTilemapComponent final : public IEntityComponent
+{
+    struct SChunkMesh
+    {
+        _smart_ptr<IStatObj> pStatObj;
+        int slotId = -1;
+
+        // Set when the tiles drawn by this mesh changed since it was baked
+        bool dirty = true;
+        // Set when only the frames of its animated tiles advanced, the texture coordinates are rewritten in place
+        bool framesDirty = false;
+    };
+
+    struct SChunk
+    {
+        // Tile indices, chunkSize * chunkSize, row-major from the bottom left
+        TLevelVector<int> tiles;
+        AABB localBounds = AABB(AABB::RESET);
+
+        // Animated tiles are baked into their own mesh, so a clip advancing only touches the few quads it covers
+        SChunkMesh staticMesh;
+        SChunkMesh animatedMesh;
+        bool hasAnimatedTiles = false;
+
+        bool IsDirty() const { return staticMesh.dirty || animatedMesh.dirty || animatedMesh.framesDirty; }
+        void MarkDirty() { staticMesh.dirty = animatedMesh.dirty = true; }
+    };
+
+    struct SAnimatedTile
+    {
+        FFlipbookAnim anim;
+        // Frame the clip showed when the chunks were last baked
+        int frame = 0;
+        // Storage for the name of clips declared by the tilemap file, anim.name points here
+        char name[16] = {};
+    };
+
+public:
+    static constexpr int kEmptyTile = -1;
+
+    CTilemapComponent() = default;
+    virtual ~CTilemapComponent() = default;
+
+    // IEntityComponent
+    virtual void Initialize() override;
+
+    virtual Cry::Entity::EventFlags GetEventMask() const override;
+    virtual void ProcessEvent(const SEntityEvent& event) override;
+    // ~IEntityComponent
+
+    // Reflect type to set a unique identifier for this component
+    static void ReflectType(Schematyc::CTypeDesc<CTilemapComponent>& desc)
+    {
+        desc.SetGUID("{6C0D7E43-52B1-4F1A-9B8E-2E5C4A7D9F10}"_cry_guid);
+        desc.SetLabel("Tilemap");
+        desc.SetEditorCategory("Rendering");
+        desc.SetDescription("Static tile grid rendered in chunks against a shared sprite atlas");
+        desc.AddMember(&CTilemapComponent::m_materialPath, 'mat', "Material", "Atlas Material", "Sprite atlas material shared by every tile", "");
+        desc.AddMember(&CTilemapComponent::m_tilemapPath, 'tmap', "TilemapFile", "Tilemap File", "Path of the .tilemap file holding the tile indices", "");
+        desc.AddMember(&CTilemapComponent::m_tileSize, 'tsiz', "TileSize", "Tile Size", "World size of a single tile", 1.f);
+        desc.AddMember(&CTilemapComponent::m_chunkSize, 'chnk', "ChunkSize", "Chunk Size", "Number of tiles along each side of a chunk, every chunk is a single draw", 32);
+    }
+
+    void Resize(int width, int height);
+    void SetTile(int x, int y, int tileIndex);
+    int GetTile(int x, int y) const;
+
+    // Plays the clip on every tile using the given index
+    void SetAnimatedTile(int tileIndex, const FFlipbookAnim& anim);
+
+private:
+    void LoadMaterial();
+    bool LoadTilemap();
+
+    void Update(float frameTime);
+    void UpdateAnimatedTiles(float frameTime);
+    void BuildChunk(SChunk& chunk, int chunkX, int chunkY, bool animated);
+    void UpdateChunkFrames(SChunk& chunk);
+    // Writes the texture coordinates of the chunk tiles drawn by the mesh, in the order they were baked
+    void WriteTexCoords(const SChunk& chunk, bool animated, SMeshTexCoord* pTexCoords) const;
+    void ReleaseChunkMesh(SChunkMesh& mesh);
+    void ReleaseChunks();
+
+    SChunk* GetChunk(int x, int y);
+    int GetFrameForTile(int tileIndex) const;
+    bool IsAnimatedTile(int tileIndex) const { return m_animatedTiles.count(tileIndex) != 0; }
+
+    Schematyc::MaterialFileName m_materialPath;
+    Schematyc::CSharedString m_tilemapPath;
+    float m_tileSize = 1.f;
+    int m_chunkSize = 32;
+
+    _smart_ptr<IMaterial> m_pMaterial;
+    int m_columns = -1;
+    int m_rows = -1;
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_chunksX = 0;
+    int m_chunksY = 0;
+    // Chunk size the chunks were laid out with, the property may have been edited since
+    int m_layoutChunkSize = 0;
+    // Only the first m_chunksX * m_chunksY chunks are in use
+    std::vector<SChunk> m_chunks;
+
+    // Keyed by tile index. Nodes never move, so names stored in them stay valid
+    std::unordered_map<int, SAnimatedTile> m_animatedTiles;
+    float m_elapsed = 0.f;
+};
@@ -0,0 +1,37 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "SpawnPoint.h"
+
+#include <CrySchematyc/Env/Elements/EnvComponent.h>
+#include <CryCore/StaticInstanceList.h>
+
+namespace
+{
+    static void RegisterSpawnPointComponent(Schematyc::IEnvRegistrar& registrar)
+    {
+        Schematyc::CEnvRegistrationScope scope = registrar.Scope(IEntity::GetEntityScopeGUID());
+        {
+            Schematyc::CEnvRegistrationScope componentScope = scope.Register(
+                SCHEMATYC_MAKE_ENV_COMPONENT(CSpawnPointComponent));
+        }
+    }
+
+    CRY_STATIC_AUTO_REGISTER_FUNCTION(&RegisterSpawnPointComponent);
+}
+
+Matrix34 CSpawnPointComponent::GetFirstSpawnPointTransform()
+{
+    IEntityItPtr pEntityIterator = gEnv->pEntitySystem->GetEntityIterator();
+    pEntityIterator->MoveFirst();
+
+    while (!pEntityIterator->IsEnd())
+    {
+        IEntity* pEntity = pEntityIterator->Next();
+        if (CSpawnPointComponent* pSpawner = pEntity->GetComponent<CSpawnPointComponent>())
+        {
+            return pSpawner->GetWorldTransformMatrix();
+        }
+    }
+
+    return IDENTITY;
+}
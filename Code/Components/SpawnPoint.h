@@ -0,0 +1,30 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+
+#include <CryEntitySystem/IEntityComponent.h>
+#include <CryEntitySystem/IEntitySystem.h>
+#include <CrySchematyc/CoreAPI.h>
+
+////////////////////////////////////////////////////////
+// Marks where players are spawned when their client connects
+////////////////////////////////////////////////////////
+class CSpawnPointComponent final : public IEntityComponent
+{
+public:
+	CSpawnPointComponent() = default;
+	virtual ~CSpawnPointComponent() = default;
+
+	// Reflect type to set a unique identifier for this component
+	// and provide additional information to expose it in the sandbox
+	static void ReflectType(Schematyc::CTypeDesc<CSpawnPointComponent>& desc)
+	{
+		desc.SetGUID("{E3D82AF4-E9FB-4498-B352-79FEFEFBE36F}"_cry_guid);
+		desc.SetEditorCategory("Game");
+		desc.SetLabel("SpawnPoint");
+		desc.SetDescription("Players are spawned at the first spawn point found in the level");
+		desc.SetComponentFlags({ IEntityComponent::EFlags::Transform, IEntityComponent::EFlags::Socket, IEntityComponent::EFlags::Attach });
+	}
+
+	// Returns the world transform of the first spawn point in the level, or identity when there is none
+	static Matrix34 GetFirstSpawnPointTransform();
+};
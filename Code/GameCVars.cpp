@@ -0,0 +1,50 @@
+#include "StdAfx.h"
+#include "GameCVars.h"
+
+#include <CrySystem/IConsole.h>
+
+SGameCVars g_gameCVars;
+
+void SGameCVars::Register()
+{
+    REGISTER_CVAR2("pl_snapshotRate", &pl_snapshotRate, pl_snapshotRate, VF_NULL,
+        "Server snapshot rate of replicated player state (snapshots per second)");
+    REGISTER_CVAR2("pl_predictionTolerance", &pl_predictionTolerance, pl_predictionTolerance, VF_NULL,
+        "Distance below which the predicted local player ignores server corrections");
+    REGISTER_CVAR2("pl_predictionSnapDistance", &pl_predictionSnapDistance, pl_predictionSnapDistance, VF_NULL,
+        "Distance above which the predicted local player snaps to the server position");
+    REGISTER_CVAR2("pl_correctionRate", &pl_correctionRate, pl_correctionRate, VF_NULL,
+        "Rate at which prediction errors and remote players converge to the server position");
+    REGISTER_CVAR2("pl_logReplicationStats", &pl_logReplicationStats, pl_logReplicationStats, VF_NULL,
+        "Log the aspect update rates of each player and the bandwidth measured on its client channel once per second (0 = off, 1 = on)");
+    REGISTER_CVAR2("pl_debugState", &pl_debugState, pl_debugState, VF_NULL,
+        "Draw the state of the local player on screen (0 = off, 1 = on)");
+    REGISTER_CVAR2("cam_smoothing", &cam_smoothing, cam_smoothing, VF_NULL,
+        "Rate at which the player camera follows mouse look (0 = immediate)");
+    REGISTER_CVAR2("cam_pitchSoftZone", &cam_pitchSoftZone, cam_pitchSoftZone, VF_NULL,
+        "Radians before a pitch limit over which mouse look slows down (0 = hard limit)");
+    REGISTER_CVAR2("cam_viewDistance", &cam_viewDistance, cam_viewDistance, VF_NULL,
+        "Distance of the player camera behind the player");
+    REGISTER_CVAR2("tm_maxChunkBuildsPerFrame", &tm_maxChunkBuildsPerFrame, tm_maxChunkBuildsPerFrame, VF_NULL,
+        "Maximum number of tilemap chunks baked per frame");
+}
+
+void SGameCVars::Unregister()
+{
+    IConsole* pConsole = gEnv->pConsole;
+    if (!pConsole)
+    {
+        return;
+    }
+
+    pConsole->UnregisterVariable("pl_snapshotRate", true);
+    pConsole->UnregisterVariable("pl_predictionTolerance", true);
+    pConsole->UnregisterVariable("pl_predictionSnapDistance", true);
+    pConsole->UnregisterVariable("pl_correctionRate", true);
+    pConsole->UnregisterVariable("pl_logReplicationStats", true);
+    pConsole->UnregisterVariable("pl_debugState", true);
+    pConsole->UnregisterVariable("cam_smoothing", true);
+    pConsole->UnregisterVariable("cam_pitchSoftZone", true);
+    pConsole->UnregisterVariable("cam_viewDistance", true);
+    pConsole->UnregisterVariable("tm_maxChunkBuildsPerFrame", true);
+}
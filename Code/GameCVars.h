@@ -0,0 +1,36 @@
+#pragma once
+
+////////////////////////////////////////////////////////
+// Console variables owned by the game module
+// Registered and unregistered by CGamePlugin
+////////////////////////////////////////////////////////
+struct SGameCVars
+{
+    void Register();
+    void Unregister();
+
+    // Server snapshot rate of replicated player state, in snapshots per second
+    float pl_snapshotRate = 20.f;
+    // Distance below which the predicted local player ignores server corrections
+    float pl_predictionTolerance = 0.05f;
+    // Distance above which the predicted local player snaps to the server position
+    float pl_predictionSnapDistance = 2.f;
+    // Rate at which prediction errors and remote players converge to the server position
+    float pl_correctionRate = 10.f;
+    // Log the aspect update rates per player and the bandwidth measured on its client channel once per second
+    int pl_logReplicationStats = 0;
+    // Draw the state of the local player on screen
+    int pl_debugState = 0;
+
+    // Rate at which the player camera follows mouse look, 0 follows it immediately
+    float cam_smoothing = 0.f;
+    // Radians before a pitch limit over which mouse look slows down, 0 for a hard limit
+    float cam_pitchSoftZone = 0.25f;
+    // Distance of the player camera behind the player
+    float cam_viewDistance = 4.f;
+
+    // Maximum number of tilemap chunks baked per frame, the rest wait for the next frames
+    int tm_maxChunkBuildsPerFrame = 4;
+};
+
+extern SGameCVars g_gameCVars;
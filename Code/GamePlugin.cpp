@@ -1,19 +1,54 @@
 // Copyright 2016-2019 Crytek GmbH / Crytek Group. All rights reserved.
 #include "StdAfx.h"
 #include "GamePlugin.h"
+#include "GameCVars.h"
 
 #include "Components/Player.h"
+#include "Components/SpawnPoint.h"
+#include "Sprites/SpriteHullLibrary.h"
+#include "Sprites/SpriteRenderQueue.h"
+#include "Sprites/SpriteMaterialPool.h"
+#include "Sprites/SpriteSheetLibrary.h"
+#include "Memory/LevelArena.h"
 
 #include <CrySchematyc/Env/IEnvRegistry.h>
 #include <CrySchematyc/Env/EnvPackage.h>
+#include <CrySystem/ICmdLine.h>
 
 // Included only once per DLL module.
 #include <CryCore/Platform/platform_impl.inl>
 
+namespace
+{
+	// Returns a player placed in the level, these are not owned by any client channel
+	IEntity* FindPlacedPlayer()
+	{
+		IEntityItPtr pEntityIterator = gEnv->pEntitySystem->GetEntityIterator();
+		pEntityIterator->MoveFirst();
+
+		while (!pEntityIterator->IsEnd())
+		{
+			IEntity* pEntity = pEntityIterator->Next();
+			if (pEntity->GetComponent<CPlayerComponent>() != nullptr && pEntity->GetNetEntity()->GetChannelId() == 0)
+				return pEntity;
+		}
+
+		return nullptr;
+	}
+}
+
 CGamePlugin::~CGamePlugin()
 {
 	gEnv->pSystem->GetISystemEventDispatcher()->RemoveListener(this);
 
+	if (gEnv->pGameFramework)
+	{
+		gEnv->pGameFramework->RemoveNetworkedClientListener(*this);
+	}
+
+	g_gameCVars.Unregister();
+	CSpriteHullLibrary::UnregisterCommands();
+
 	if (gEnv->pSchematyc)
 	{
 		gEnv->pSchematyc->GetEnvRegistry().DeregisterPackage(CGamePlugin::GetCID());
@@ -24,10 +59,21 @@ bool CGamePlugin::Initialize(SSystemGlobalEnvironment& env, const SSystemInitPar
 {
 	// Register for engine system events, in our case we need ESYSTEM_EVENT_GAME_POST_INIT to load the map
 	gEnv->pSystem->GetISystemEventDispatcher()->RegisterListener(this, "CGamePlugin");
+
+	g_gameCVars.Register();
+	CSpriteHullLibrary::RegisterCommands();
+
+	// Sprites are ordered once per frame, after entities have updated
+	EnableUpdate(EUpdateStep::MainUpdate, true);
 	
 	return true;
 }
 
+void CGamePlugin::MainUpdate(float frameTime)
+{
+	CSpriteRenderQueue::Get().Update();
+}
+
 void CGamePlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UINT_PTR lparam)
 {
 	switch (event)
@@ -35,15 +81,40 @@ void CGamePlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UINT_PTR lp
 		// Called when the game framework has initialized and we are ready for game logic to start
 		case ESYSTEM_EVENT_GAME_POST_INIT:
 		{
+			// Listen for client connection events, in order to create the local player
+			gEnv->pGameFramework->AddNetworkedClientListener(*this);
+
+			// Report level loading progress and precache sprite assets before gameplay starts
+			m_levelLoader.Initialize();
+
 			// Don't need to load the map in editor
 			if (!gEnv->IsEditor())
 			{
 				// Load the example map in client server mode
-				gEnv->pConsole->ExecuteString("map tropical_toon_island", false, true);
+				// Skipped when the command line already selects a session, e.g. "+map tropical_toon_island s"
+				// on a loopback server and "+connect 127.0.0.1" on each additional client
+				const ICmdLine* pCmdLine = gEnv->pSystem->GetICmdLine();
+				if (!pCmdLine->FindArg(eCLAT_Post, "map") && !pCmdLine->FindArg(eCLAT_Post, "connect"))
+				{
+					m_levelLoader.Load("tropical_toon_island", true);
+				}
 			}
 		}
 		break;
 
+		// Release the sprite state of the previous level in one step
+		case ESYSTEM_EVENT_LEVEL_POST_UNLOAD:
+		{
+			m_levelLoader.LogMemoryStatistics();
+
+			CSpriteHullLibrary::Get().Clear();
+			CSpriteSheetLibrary::Get().Clear();
+			CSpriteMaterialPool::Get().Clear();
+			CSpriteRenderQueue::Get().ClearAtlasIds();
+			CLevelArena::Get().Reset();
+		}
+		break;
+
 		case ESYSTEM_EVENT_REGISTER_SCHEMATYC_ENV:
 		{
 			// Register all components that belong to this plug-in
@@ -70,5 +141,85 @@ void CGamePlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UINT_PTR lp
 	}
 }
 
+bool CGamePlugin::OnClientConnectionReceived(int channelId, bool bIsReset)
+{
+	// Connection received from a client, create a player entity and component
+	SEntitySpawnParams spawnParams;
+	spawnParams.pClass = gEnv->pEntitySystem->GetClassRegistry()->GetDefaultClass();
+
+	// Set a unique name for the player entity
+	const string playerName = string().Format("Player%" PRISIZE_T, m_players.size());
+	spawnParams.sName = playerName;
+
+	// Spawn at the first spawn point in the level
+	const Matrix34 spawnTransform = CSpawnPointComponent::GetFirstSpawnPointTransform();
+	spawnParams.vPosition = spawnTransform.GetTranslation();
+	spawnParams.qRotation = Quat(spawnTransform);
+
+	// Set local player details
+	if (m_players.empty() && !gEnv->IsDedicated())
+	{
+		// A player placed in the level is driven by the local client, don't spawn a second one next to it
+		if (IEntity* pPlacedPlayer = FindPlacedPlayer())
+		{
+			m_players.emplace(std::make_pair(channelId, pPlacedPlayer->GetId()));
+			return true;
+		}
+
+		spawnParams.id = LOCAL_PLAYER_ENTITY_ID;
+		spawnParams.nFlags |= ENTITY_FLAG_LOCAL_PLAYER;
+	}
+
+	// Spawn the player entity
+	if (IEntity* pPlayerEntity = gEnv->pEntitySystem->SpawnEntity(spawnParams))
+	{
+		// Set the local player entity channel id, and bind it to the network so that it can support Multiplayer contexts
+		pPlayerEntity->GetNetEntity()->SetChannelId(channelId);
+
+		// Create the player component instance
+		if (pPlayerEntity->GetOrCreateComponent<CPlayerComponent>() != nullptr)
+		{
+			// Push the entity into our map, with the channel id as the key
+			m_players.emplace(std::make_pair(channelId, pPlayerEntity->GetId()));
+		}
+	}
+
+	return true;
+}
+
+bool CGamePlugin::OnClientReadyForGameplay(int channelId, bool bIsReset)
+{
+	// Revive players when the network reports that the client is connected and ready for gameplay
+	auto it = m_players.find(channelId);
+	if (it != m_players.end())
+	{
+		if (IEntity* pPlayerEntity = gEnv->pEntitySystem->GetEntity(it->second))
+		{
+			if (CPlayerComponent* pPlayer = pPlayerEntity->GetComponent<CPlayerComponent>())
+			{
+				pPlayer->OnReadyForGameplayOnServer();
+			}
+		}
+	}
+
+	return true;
+}
+
+void CGamePlugin::OnClientDisconnected(int channelId, EDisconnectionCause cause, const char* description, bool bKeepClient)
+{
+	// Client disconnected, remove the entity and from map
+	auto it = m_players.find(channelId);
+	if (it != m_players.end())
+	{
+		// Players placed in the level belong to the level, only remove the ones spawned for the channel
+		IEntity* pPlayerEntity = gEnv->pEntitySystem->GetEntity(it->second);
+		if (pPlayerEntity != nullptr && pPlayerEntity->GetNetEntity()->GetChannelId() == channelId)
+		{
+			gEnv->pEntitySystem->RemoveEntity(it->second);
+		}
+
+		m_players.erase(it);
+	}
+}
 
 CRYREGISTER_SINGLETON_CLASS(CGamePlugin)
@@ -2,6 +2,10 @@
 #pragma once
 
 #include <CrySystem/ICryPlugin.h>
+#include <CryGame/IGameFramework.h>
+#include <CryNetwork/INetwork.h>
+
+#include "LevelLoader.h"
 
 class CPlayerComponent;
 
@@ -11,6 +15,7 @@ class CPlayerComponent;
 class CGamePlugin 
 	: public Cry::IEnginePlugin
 	, public ISystemEventListener
+	, public INetworkedClientListener
 {
 public:
 	CRYINTERFACE_SIMPLE(Cry::IEnginePlugin)
@@ -21,11 +26,29 @@ public:
 	// Cry::IEnginePlugin
 	virtual const char* GetCategory() const override { return "Game"; }
 	virtual bool Initialize(SSystemGlobalEnvironment& env, const SSystemInitParams& initParams) override;
+	virtual void MainUpdate(float frameTime) override;
 	// ~Cry::IEnginePlugin
 
 	// ISystemEventListener
 	virtual void OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UINT_PTR lparam) override;
 	// ~ISystemEventListener
+
+	// INetworkedClientListener
+	// Sent to the local client on disconnect
+	virtual void OnLocalClientDisconnected(EDisconnectionCause cause, const char* description) override {}
+
+	// Sent to the server when a new client has started connecting
+	// Return false to disallow the connection
+	virtual bool OnClientConnectionReceived(int channelId, bool bIsReset) override;
+	// Sent to the server when a new client has finished connecting and is ready for gameplay
+	// Return false to disallow the connection and kick the player
+	virtual bool OnClientReadyForGameplay(int channelId, bool bIsReset) override;
+	// Sent to the server when a client is disconnected
+	virtual void OnClientDisconnected(int channelId, EDisconnectionCause cause, const char* description, bool bKeepClient) override;
+	// Sent to the server when a client is timing out (no packets for X seconds)
+	// Return true to allow disconnection, otherwise false to keep client.
+	virtual bool OnClientTimingOut(int channelId, EDisconnectionCause cause, const char* description) override { return true; }
+	// ~INetworkedClientListener
 	
 	// Helper function to get the CGamePlugin instance
 	// Note that CGamePlugin is declared as a singleton, so the CreateClassInstance will always return the same pointer
@@ -33,4 +56,12 @@ public:
 	{
 		return cryinterface_cast<CGamePlugin>(CGamePlugin::s_factory.CreateClassInstance().get());
 	}
+
+	CLevelLoader& GetLevelLoader() { return m_levelLoader; }
+
+protected:
+	CLevelLoader m_levelLoader;
+
+	// Map containing player entities, key is the channel id received in OnClientConnectionReceived
+	std::unordered_map<int, EntityId> m_players;
 };
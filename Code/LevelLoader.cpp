@@ -0,0 +1,179 @@
+#include "StdAfx.h"
+#include "LevelLoader.h"
+#include "GamePlugin.h"
+
+#include "Components/Schematyc/SpriteFlipbookComponent.h"
+#include "Memory/LevelArena.h"
+#include "Sprites/SpriteMaterialPool.h"
+
+#include <CryEntitySystem/IEntitySystem.h>
+
+namespace
+{
+    const char* GetStageName(CLevelLoader::EStage stage)
+    {
+        switch (stage)
+        {
+        case CLevelLoader::EStage::Idle: return "Idle";
+        case CLevelLoader::EStage::Loading: return "Loading";
+        case CLevelLoader::EStage::LoadingEntities: return "LoadingEntities";
+        case CLevelLoader::EStage::Precaching: return "Precaching";
+        case CLevelLoader::EStage::Ready: return "Ready";
+        case CLevelLoader::EStage::Failed: return "Failed";
+        default: return "Unknown";
+        }
+    }
+
+    void CmdLevelMemoryStats(IConsoleCmdArgs* pArgs)
+    {
+        CGamePlugin::GetInstance()->GetLevelLoader().LogMemoryStatistics();
+    }
+}
+
+CLevelLoader::~CLevelLoader()
+{
+    if (gEnv->pConsole)
+    {
+        gEnv->pConsole->RemoveCommand("level_memoryStats");
+    }
+
+    if (gEnv->pGameFramework && gEnv->pGameFramework->GetILevelSystem())
+    {
+        gEnv->pGameFramework->GetILevelSystem()->RemoveListener(this);
+    }
+}
+
+void CLevelLoader::Initialize()
+{
+    gEnv->pGameFramework->GetILevelSystem()->AddListener(this);
+
+    REGISTER_COMMAND("level_memoryStats", CmdLevelMemoryStats, VF_NULL, "Logs level arena and sprite material pool statistics of the current level");
+}
+
+void CLevelLoader::Load(const char* szLevelName, bool bServer)
+{
+    m_progress = 0;
+    SetStage(EStage::Loading);
+
+    // Deferred execution, the level system picks it up at the start of the next frame
+    string command;
+    command.Format("map %s%s", szLevelName, bServer ? " s" : "");
+    gEnv->pConsole->ExecuteString(command.c_str(), false, true);
+}
+
+void CLevelLoader::SetStage(EStage stage)
+{
+    m_stage = stage;
+
+    if (stage == EStage::Loading)
+    {
+        m_loadStartTime = gEnv->pTimer->GetAsyncTime();
+    }
+
+    CryLog("[LevelLoader] %s (%.2fs)", GetStageName(stage), (gEnv->pTimer->GetAsyncTime() - m_loadStartTime).GetSeconds());
+}
+
+void CLevelLoader::OnLevelNotFound(const char* szLevelName)
+{
+    CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Level %s not found!", szLevelName);
+    SetStage(EStage::Failed);
+}
+
+void CLevelLoader::OnLoadingStart(ILevelInfo* pLevel)
+{
+    m_progress = 0;
+    SetStage(EStage::Loading);
+}
+
+void CLevelLoader::OnLoadingLevelEntitiesStart(ILevelInfo* pLevel)
+{
+    SetStage(EStage::LoadingEntities);
+}
+
+void CLevelLoader::OnLoadingComplete(ILevelInfo* pLevel)
+{
+    // Entities exist now, but gameplay has not started yet
+    SetStage(EStage::Precaching);
+    PrecacheSprites();
+
+    // Anything allocated from here on happens at spawn time and shows up in the statistics
+    CLevelArena::Get().MarkWarmUpComplete();
+    CSpriteMaterialPool::Get().MarkWarmUpComplete();
+    LogMemoryStatistics();
+
+    SetStage(EStage::Ready);
+}
+
+void CLevelLoader::OnLoadingError(ILevelInfo* pLevel, const char* szError)
+{
+    CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Failed to load level: %s", szError);
+    SetStage(EStage::Failed);
+}
+
+void CLevelLoader::OnLoadingProgress(ILevelInfo* pLevel, int progressAmount)
+{
+    m_progress = progressAmount;
+    CryLog("[LevelLoader] %s progress %d", GetStageName(m_stage), progressAmount);
+}
+
+void CLevelLoader::OnUnloadComplete(ILevelInfo* pLevel)
+{
+    m_precachedMaterials.clear();
+    m_progress = 0;
+    m_stage = EStage::Idle;
+}
+
+void CLevelLoader::PrecacheSprites()
+{
+    m_precachedMaterials.clear();
+
+    const CTimeValue precacheStartTime = gEnv->pTimer->GetAsyncTime();
+    IMaterialManager* pMaterialManager = gEnv->p3DEngine->GetMaterialManager();
+
+    int spriteCount = 0;
+    std::unordered_set<string> atlasPaths;
+    DynArray<CSpriteFlipbookComponent*> sprites;
+
+    IEntityItPtr pIterator = gEnv->pEntitySystem->GetEntityIterator();
+    pIterator->MoveFirst();
+    while (IEntity* pEntity = pIterator->Next())
+    {
+        sprites.clear();
+        pEntity->GetAllComponents<CSpriteFlipbookComponent>(sprites);
+
+        for (CSpriteFlipbookComponent* pSprite : sprites)
+        {
+            const char* szMaterialPath = pSprite->GetMaterialPath();
+            if (szMaterialPath[0] == '\0')
+                continue;
+
+            // Each atlas is loaded from disk and queued for texture streaming once
+            if (atlasPaths.insert(szMaterialPath).second)
+            {
+                if (IMaterial* pMaterial = pMaterialManager->LoadMaterial(szMaterialPath))
+                {
+                    pMaterial->RequestTexturesLoading(0.f);
+                    m_precachedMaterials.emplace_back(pMaterial);
+                }
+            }
+
+            // Clones the atlas and resolves its shader parameters now instead of on GameplayStarted
+            pSprite->LoadMaterial();
+            ++spriteCount;
+        }
+    }
+
+    CryLog("[LevelLoader] Precached %" PRISIZE_T " sprite atlases for %d sprites in %.2fs",
+        m_precachedMaterials.size(), spriteCount, (gEnv->pTimer->GetAsyncTime() - precacheStartTime).GetSeconds());
+}
+
+void CLevelLoader::LogMemoryStatistics() const
+{
+    const CLevelArena::SStats& arenaStats = CLevelArena::Get().GetStats();
+    const CSpriteMaterialPool::SStats& poolStats = CSpriteMaterialPool::Get().GetStats();
+
+    CryLogAlways("[LevelMemory] Arena: %u allocations (%u after warm-up), %" PRISIZE_T " bytes in use, %" PRISIZE_T " peak, %" PRISIZE_T " reserved",
+        arenaStats.allocationCount, arenaStats.allocationsAfterWarmUp, arenaStats.bytesInUse, arenaStats.peakBytes, arenaStats.reservedBytes);
+    CryLogAlways("[LevelMemory] Sprite materials: %u variants (%u after warm-up), %u shared, %u sprites, %u peak",
+        poolStats.variantsCreated, poolStats.variantsCreatedAfterWarmUp, poolStats.variantsShared, poolStats.users, poolStats.peakUsers);
+}
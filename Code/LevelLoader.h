@@ -0,0 +1,66 @@
+#pragma once
+
+#include <CryGame/IGameFramework.h>
+#include <ILevelSystem.h>
+
+////////////////////////////////////////////////////////
+// Tracks level loading progress and precaches sprite assets before gameplay starts
+//
+// The level itself is loaded by the level system on the main thread, Load() only queues it
+// so the current frame can finish. Stage and progress follow the level system callbacks and
+// can be polled by UI code, e.g. a loading screen or level system listener.
+//
+// Sprite atlases referenced by the level are loaded once the entities exist, while the
+// loading screen is still up, and their textures are queued for streaming so that the
+// first gameplay frames don't stall on material loads.
+////////////////////////////////////////////////////////
+class CLevelLoader final : public ILevelSystemListener
+{
+public:
+    enum class EStage
+    {
+        Idle,
+        Loading,
+        LoadingEntities,
+        Precaching,
+        Ready,
+        Failed
+    };
+
+    CLevelLoader() = default;
+    virtual ~CLevelLoader();
+
+    void Initialize();
+
+    // Queues the level load, it starts on the next frame so the current one can finish
+    void Load(const char* szLevelName, bool bServer);
+
+    // Logs the level arena and sprite material pool statistics of the current level
+    void LogMemoryStatistics() const;
+
+    EStage GetStage() const { return m_stage; }
+    bool IsLoading() const { return m_stage == EStage::Loading || m_stage == EStage::LoadingEntities || m_stage == EStage::Precaching; }
+    // Last amount reported by ILevelSystemListener::OnLoadingProgress for the current load
+    int GetProgress() const { return m_progress; }
+
+    // ILevelSystemListener
+    virtual void OnLevelNotFound(const char* szLevelName) override;
+    virtual void OnLoadingStart(ILevelInfo* pLevel) override;
+    virtual void OnLoadingLevelEntitiesStart(ILevelInfo* pLevel) override;
+    virtual void OnLoadingComplete(ILevelInfo* pLevel) override;
+    virtual void OnLoadingError(ILevelInfo* pLevel, const char* szError) override;
+    virtual void OnLoadingProgress(ILevelInfo* pLevel, int progressAmount) override;
+    virtual void OnUnloadComplete(ILevelInfo* pLevel) override;
+    // ~ILevelSystemListener
+
+private:
+    void SetStage(EStage stage);
+    void PrecacheSprites();
+
+    EStage m_stage = EStage::Idle;
+    int m_progress = 0;
+    CTimeValue m_loadStartTime;
+
+    // Keeps the source atlas materials alive for the lifetime of the level
+    std::vector<_smart_ptr<IMaterial>> m_precachedMaterials;
+};
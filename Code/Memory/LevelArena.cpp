@@ -0,0 +1,64 @@
+#include "StdAfx.h"
+#include "LevelArena.h"
+
+CLevelArena& CLevelArena::Get()
+{
+    static CLevelArena s_arena;
+    return s_arena;
+}
+
+CLevelArena::~CLevelArena()
+{
+    for (const SBlock& block : m_blocks)
+    {
+        CryModuleMemalignFree(block.pMemory);
+    }
+}
+
+void* CLevelArena::Allocate(size_t size, size_t alignment)
+{
+    ++m_stats.allocationCount;
+    if (m_warmUpComplete)
+    {
+        ++m_stats.allocationsAfterWarmUp;
+    }
+
+    for (;;)
+    {
+        if (m_currentBlock < m_blocks.size())
+        {
+            const SBlock& block = m_blocks[m_currentBlock];
+            const size_t offset = (m_blockOffset + alignment - 1) & ~(alignment - 1);
+
+            if (offset + size <= block.size)
+            {
+                m_blockOffset = offset + size;
+                m_stats.bytesInUse += size;
+                m_stats.peakBytes = max(m_stats.peakBytes, m_stats.bytesInUse);
+                return block.pMemory + offset;
+            }
+
+            // Move on to the next block, the tail of this one stays unused until the next reset
+            ++m_currentBlock;
+            m_blockOffset = 0;
+            continue;
+        }
+
+        // Oversized requests get a block of their own
+        const size_t blockSize = max(kBlockSize, size + alignment);
+        m_blocks.push_back({ static_cast<uint8*>(CryModuleMemalign(blockSize, 16)), blockSize });
+        m_stats.reservedBytes += blockSize;
+    }
+}
+
+void CLevelArena::Reset()
+{
+    m_currentBlock = 0;
+    m_blockOffset = 0;
+    m_warmUpComplete = false;
+
+    // The blocks are kept for the next level
+    const size_t reservedBytes = m_stats.reservedBytes;
+    m_stats = SStats();
+    m_stats.reservedBytes = reservedBytes;
+}
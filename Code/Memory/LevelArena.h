@@ -0,0 +1,83 @@
+#pragma once
+
+////////////////////////////////////////////////////////
+// Bump allocator for runtime state that lives as long as the loaded level
+//
+// Allocations are never freed individually, the whole arena is reset in one step when
+// the level unloads. Its blocks are kept and reused by the next level, so level
+// transitions don't fragment the heap. Only trivially destructible data belongs here.
+////////////////////////////////////////////////////////
+class CLevelArena
+{
+public:
+    struct SStats
+    {
+        uint32 allocationCount = 0;
+        // Allocations made after the level finished loading and precaching
+        uint32 allocationsAfterWarmUp = 0;
+        size_t bytesInUse = 0;
+        size_t peakBytes = 0;
+        size_t reservedBytes = 0;
+    };
+
+    static constexpr size_t kBlockSize = 256 * 1024;
+
+    static CLevelArena& Get();
+
+    ~CLevelArena();
+
+    void* Allocate(size_t size, size_t alignment);
+
+    template<typename T>
+    T* AllocateArray(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "Level arena memory is released without running destructors");
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // Called once the level is loaded, later allocations are counted as spawn time allocations
+    void MarkWarmUpComplete() { m_warmUpComplete = true; }
+
+    // Releases every allocation of the level at once
+    void Reset();
+
+    const SStats& GetStats() const { return m_stats; }
+
+private:
+    struct SBlock
+    {
+        uint8* pMemory;
+        size_t size;
+    };
+
+    std::vector<SBlock> m_blocks;
+    size_t m_currentBlock = 0;
+    size_t m_blockOffset = 0;
+
+    bool m_warmUpComplete = false;
+    SStats m_stats;
+};
+
+////////////////////////////////////////////////////////
+// Standard allocator drawing from the level arena, deallocation is a no-op
+////////////////////////////////////////////////////////
+template<typename T>
+struct SLevelArenaAllocator
+{
+    using value_type = T;
+
+    SLevelArenaAllocator() = default;
+    template<typename U>
+    SLevelArenaAllocator(const SLevelArenaAllocator<U>&) {}
+
+    T* allocate(size_t count) { return CLevelArena::Get().AllocateArray<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    template<typename U>
+    bool operator==(const SLevelArenaAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const SLevelArenaAllocator<U>&) const { return false; }
+};
+
+template<typename T>
+using TLevelVector = std::vector<T, SLevelArenaAllocator<T>>;
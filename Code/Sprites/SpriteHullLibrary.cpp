@@ -0,0 +1,277 @@
+#include "StdAfx.h"
+#include "SpriteHullLibrary.h"
+
+#include <Cry3DEngine/IIndexedMesh.h>
+#include <CrySystem/File/ICryPak.h>
+#include <CrySystem/IConsole.h>
+
+namespace
+{
+    void CmdHullStats(IConsoleCmdArgs* pArgs)
+    {
+        CSpriteHullLibrary::Get().LogStatistics();
+    }
+
+    // Splits the next whitespace separated token off the line
+    bool NextToken(const char*& szCursor, string& token)
+    {
+        while (*szCursor == ' ' || *szCursor == '\t')
+            ++szCursor;
+
+        const char* szStart = szCursor;
+        while (*szCursor != '\0' && *szCursor != ' ' && *szCursor != '\t')
+            ++szCursor;
+
+        token.assign(szStart, szCursor);
+        return !token.empty();
+    }
+}
+
+CSpriteHullLibrary& CSpriteHullLibrary::Get()
+{
+    static CSpriteHullLibrary s_library;
+    return s_library;
+}
+
+void CSpriteHullLibrary::RegisterCommands()
+{
+    REGISTER_COMMAND("sprite_hullStats", CmdHullStats, VF_NULL, "Logs the overdraw statistics of every loaded sprite atlas");
+}
+
+void CSpriteHullLibrary::UnregisterCommands()
+{
+    if (gEnv->pConsole)
+    {
+        gEnv->pConsole->RemoveCommand("sprite_hullStats");
+    }
+}
+
+const SSpriteHullSet* CSpriteHullLibrary::FindOrLoad(const char* szMaterialPath, const int tilesX, const int tilesY)
+{
+    auto it = m_hullSets.find(szMaterialPath);
+    if (it != m_hullSets.end())
+    {
+        return it->second.get();
+    }
+
+    if (tilesX <= 0 || tilesY <= 0)
+    {
+        return m_hullSets.emplace(szMaterialPath, nullptr).first->second.get();
+    }
+
+    // Hulls live next to the atlas material, e.g. player.mtl -> player.spritehull
+    const string hullPath = PathUtil::ReplaceExtension(szMaterialPath, "spritehull");
+    std::unique_ptr<SSpriteHullSet> pHullSet = Load(hullPath);
+    if (pHullSet && (pHullSet->tilesX != tilesX || pHullSet->tilesY != tilesY))
+    {
+        CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Sprite hulls of %s don't match its %dx%d tiles, drawing quads", szMaterialPath, tilesX, tilesY);
+        pHullSet = nullptr;
+    }
+
+    if (!pHullSet)
+    {
+        pHullSet = stl::make_unique<SSpriteHullSet>();
+        pHullSet->tilesX = tilesX;
+        pHullSet->tilesY = tilesY;
+        pHullSet->frames.resize(tilesX * tilesY);
+    }
+
+    // Frames without a usable hull draw the full tile
+    static const Vec2 s_quad[] = { Vec2(0.f, 0.f), Vec2(1.f, 0.f), Vec2(1.f, 1.f), Vec2(0.f, 1.f) };
+    for (int row = 0; row < tilesY; ++row)
+    {
+        for (int column = 0; column < tilesX; ++column)
+        {
+            _smart_ptr<IStatObj>& pFrame = pHullSet->frames[row * tilesX + column];
+            if (!pFrame)
+            {
+                pFrame = CreateTileMesh(s_quad, CRY_ARRAY_COUNT(s_quad), column, row);
+            }
+        }
+    }
+
+    return m_hullSets.emplace(szMaterialPath, std::move(pHullSet)).first->second.get();
+}
+
+std::unique_ptr<SSpriteHullSet> CSpriteHullLibrary::Load(const char* szHullPath) const
+{
+    FILE* pFile = gEnv->pCryPak->FOpen(szHullPath, "rb");
+    if (!pFile)
+    {
+        return nullptr;
+    }
+
+    const size_t fileSize = gEnv->pCryPak->FGetSize(pFile);
+    string contents;
+    contents.resize(fileSize);
+    gEnv->pCryPak->FReadRaw(contents.begin(), 1, fileSize, pFile);
+    gEnv->pCryPak->FClose(pFile);
+
+    std::unique_ptr<SSpriteHullSet> pHullSet = stl::make_unique<SSpriteHullSet>();
+
+    size_t lineStart = 0;
+    string line;
+    string token;
+    std::vector<Vec2> hull;
+
+    while (lineStart < contents.length())
+    {
+        size_t lineEnd = contents.find('\n', lineStart);
+        if (lineEnd == string::npos)
+            lineEnd = contents.length();
+
+        line = contents.substr(lineStart, lineEnd - lineStart);
+        line.TrimRight("\r");
+        lineStart = lineEnd + 1;
+
+        const char* szCursor = line.c_str();
+        if (!NextToken(szCursor, token))
+            continue;
+
+        if (token == "atlas")
+        {
+            int width = 0, height = 0;
+            if (sscanf(szCursor, "%d %d %d %d", &width, &height, &pHullSet->tilesX, &pHullSet->tilesY) != 4 ||
+                pHullSet->tilesX <= 0 || pHullSet->tilesY <= 0)
+            {
+                CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Invalid atlas line in %s!", szHullPath);
+                return nullptr;
+            }
+
+            pHullSet->frames.resize(pHullSet->tilesX * pHullSet->tilesY);
+            pHullSet->hasHulls = true;
+        }
+        else if (token == "stats")
+        {
+            sscanf(szCursor, "%f %f %f", &pHullSet->quadPixels, &pHullSet->hullPixels, &pHullSet->opaquePixels);
+        }
+        else if (token == "frame")
+        {
+            int column = 0, row = 0, vertexCount = 0;
+            int consumed = 0;
+            if (sscanf(szCursor, "%d %d %d%n", &column, &row, &vertexCount, &consumed) != 3 ||
+                column < 0 || row < 0 || column >= pHullSet->tilesX || row >= pHullSet->tilesY)
+            {
+                CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Skipping invalid frame line in %s", szHullPath);
+                continue;
+            }
+            szCursor += consumed;
+
+            hull.clear();
+            for (int i = 0; i < vertexCount; ++i)
+            {
+                Vec2 vertex;
+                if (sscanf(szCursor, "%f %f%n", &vertex.x, &vertex.y, &consumed) != 2)
+                    break;
+
+                szCursor += consumed;
+                hull.push_back(vertex);
+            }
+
+            if (hull.size() >= 3)
+            {
+                pHullSet->frames[row * pHullSet->tilesX + column] = CreateTileMesh(hull.data(), int(hull.size()), column, row);
+            }
+        }
+    }
+
+    if (pHullSet->frames.empty())
+    {
+        CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "No atlas description found in %s!", szHullPath);
+        return nullptr;
+    }
+
+    return pHullSet;
+}
+
+_smart_ptr<IStatObj> CSpriteHullLibrary::CreateTileMesh(const Vec2* pHull, const int vertexCount, const int column, const int row)
+{
+    // The sprite shader divides texture coordinates by the tile count of the atlas
+    std::vector<Vec2> texCoords(pHull, pHull + vertexCount);
+    for (Vec2& texCoord : texCoords)
+    {
+        texCoord += Vec2(float(column), float(row));
+    }
+
+    return CreateFrameMesh(pHull, texCoords.data(), vertexCount);
+}
+
+_smart_ptr<IStatObj> CSpriteHullLibrary::CreateFrameMesh(const Vec2* pCanvasCoords, const Vec2* pTexCoords, const int vertexCount)
+{
+    _smart_ptr<IStatObj> pStatObj = gEnv->p3DEngine->CreateStatObj();
+    IIndexedMesh* pIndexedMesh = pStatObj->GetIndexedMesh(true);
+    CMesh* pMesh = pIndexedMesh->GetMesh();
+
+    const int indexCount = (vertexCount - 2) * 3;
+
+    pMesh->SetVertexCount(vertexCount);
+    pMesh->SetTexCoordsAndTangentsCount(vertexCount);
+    pMesh->SetIndexCount(indexCount);
+
+    Vec3* pPositions = pMesh->GetStreamPtr<Vec3>(CMesh::POSITIONS);
+    SMeshNormal* pNormals = pMesh->GetStreamPtr<SMeshNormal>(CMesh::NORMALS);
+    SMeshTexCoord* pMeshTexCoords = pMesh->GetStreamPtr<SMeshTexCoord>(CMesh::TEXCOORDS);
+    SMeshTangents* pTangents = pMesh->GetStreamPtr<SMeshTangents>(CMesh::TANGENTS);
+    vtx_idx* pIndices = pMesh->GetStreamPtr<vtx_idx>(CMesh::INDICES);
+
+    // Matches primitive_plane.cgf: a unit plane centred on the origin facing +Z, with v pointing down -Y
+    AABB bounds(AABB::RESET);
+    float signedArea = 0.f;
+    for (int i = 0; i < vertexCount; ++i)
+    {
+        const Vec2& uv = pCanvasCoords[i];
+        pPositions[i] = Vec3(uv.x - 0.5f, 0.5f - uv.y, 0.f);
+        pNormals[i] = SMeshNormal(Vec3(0.f, 0.f, 1.f));
+        pMeshTexCoords[i] = SMeshTexCoord(pTexCoords[i].x, pTexCoords[i].y);
+        pTangents[i] = SMeshTangents(Vec3(1.f, 0.f, 0.f), Vec3(0.f, -1.f, 0.f), Vec3(0.f, 0.f, 1.f));
+        bounds.Add(pPositions[i]);
+
+        const Vec2& next = pCanvasCoords[(i + 1) % vertexCount];
+        signedArea += (uv.x - 0.5f) * (0.5f - next.y) - (next.x - 0.5f) * (0.5f - uv.y);
+    }
+
+    // The hull is convex, so a fan covers it. Wind it counter-clockwise around +Z regardless of the input order
+    const bool flip = signedArea < 0.f;
+    for (int i = 0; i < vertexCount - 2; ++i)
+    {
+        pIndices[i * 3 + 0] = 0;
+        pIndices[i * 3 + 1] = flip ? i + 2 : i + 1;
+        pIndices[i * 3 + 2] = flip ? i + 1 : i + 2;
+    }
+
+    SMeshSubset subset;
+    subset.nFirstIndexId = 0;
+    subset.nNumIndices = indexCount;
+    subset.nFirstVertId = 0;
+    subset.nNumVerts = vertexCount;
+    subset.nMatID = 0;
+    subset.nMatFlags = 0;
+    subset.nPhysicalizeType = PHYS_GEOM_TYPE_NONE;
+    pMesh->m_subsets.push_back(subset);
+    pMesh->m_bbox = bounds;
+
+    pStatObj->Invalidate(true);
+    return pStatObj;
+}
+
+void CSpriteHullLibrary::LogStatistics() const
+{
+    CryLogAlways("Sprite atlas overdraw (pixels shaded when drawing every frame once):");
+
+    for (const auto& hullSet : m_hullSets)
+    {
+        const SSpriteHullSet* pHullSet = hullSet.second.get();
+        if (!pHullSet || !pHullSet->hasHulls)
+        {
+            CryLogAlways("  %s: no hulls, full quads", hullSet.first.c_str());
+            continue;
+        }
+
+        const float quadPixels = max(pHullSet->quadPixels, 1.f);
+        CryLogAlways("  %s: quad %.0f, hull %.0f (%.1f%%), opaque %.0f (%.1f%%)",
+            hullSet.first.c_str(),
+            pHullSet->quadPixels,
+            pHullSet->hullPixels, 100.f * pHullSet->hullPixels / quadPixels,
+            pHullSet->opaquePixels, 100.f * pHullSet->opaquePixels / quadPixels);
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Cry3DEngine/IStatObj.h>
+
+////////////////////////////////////////////////////////
+// Frame meshes of a grid atlas, one set per atlas shared by every sprite using it
+//
+// Frames are alpha-trimmed by SpriteHullBuilder when the atlas has hull data and are full
+// quads otherwise. Texture coordinates are in tile units and already include the offset
+// of the frame tile, so the material never changes between frames.
+////////////////////////////////////////////////////////
+struct SSpriteHullSet
+{
+    int tilesX = 0;
+    int tilesY = 0;
+    // False when no hull data matched the atlas and every frame is a quad
+    bool hasHulls = false;
+
+    // Pixels shaded when drawing every frame once, as reported by the builder
+    float quadPixels = 0.f;
+    float hullPixels = 0.f;
+    float opaquePixels = 0.f;
+
+    // Indexed by row * tilesX + column
+    std::vector<_smart_ptr<IStatObj>> frames;
+
+    IStatObj* GetFrame(int column, int row) const
+    {
+        if (column < 0 || row < 0 || column >= tilesX || row >= tilesY)
+            return nullptr;
+
+        return frames[row * tilesX + column];
+    }
+};
+
+class CSpriteHullLibrary
+{
+public:
+    static CSpriteHullLibrary& Get();
+
+    // Returns the frames of the atlas material, trimmed to the hulls generated for it when they
+    // match its grid. Null only when the grid itself is invalid.
+    const SSpriteHullSet* FindOrLoad(const char* szMaterialPath, int tilesX, int tilesY);
+
+    void Clear() { m_hullSets.clear(); }
+
+    // Prints the overdraw statistics of every loaded atlas
+    void LogStatistics() const;
+
+    static void RegisterCommands();
+    static void UnregisterCommands();
+
+    // Builds a convex frame polygon on the unit sprite plane. Canvas coordinates are 0..1 with v down,
+    // texture coordinates are passed to the material unchanged.
+    static _smart_ptr<IStatObj> CreateFrameMesh(const Vec2* pCanvasCoords, const Vec2* pTexCoords, int vertexCount);
+
+private:
+    std::unique_ptr<SSpriteHullSet> Load(const char* szHullPath) const;
+    // Builds the mesh of one grid tile, the hull is in tile space with v down
+    static _smart_ptr<IStatObj> CreateTileMesh(const Vec2* pHull, int vertexCount, int column, int row);
+
+    // Keyed by material path, holds null for atlases with an invalid grid so the lookup is only done once
+    std::unordered_map<string, std::unique_ptr<SSpriteHullSet>> m_hullSets;
+};
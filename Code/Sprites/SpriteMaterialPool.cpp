@@ -0,0 +1,81 @@
+#include "StdAfx.h"
+#include "SpriteMaterialPool.h"
+
+CSpriteMaterialPool& CSpriteMaterialPool::Get()
+{
+    static CSpriteMaterialPool s_pool;
+    return s_pool;
+}
+
+_smart_ptr<IMaterial> CSpriteMaterialPool::Acquire(IMaterial* pSourceMaterial, const int paletteRow)
+{
+    ++m_stats.users;
+    m_stats.peakUsers = max(m_stats.peakUsers, m_stats.users);
+
+    std::vector<SVariant>& variants = m_variants[pSourceMaterial->GetName()];
+    for (SVariant& variant : variants)
+    {
+        if (variant.paletteRow == paletteRow)
+        {
+            ++variant.userCount;
+            ++m_stats.variantsShared;
+            return variant.pMaterial;
+        }
+    }
+
+    _smart_ptr<IMaterial> pVariant = gEnv->p3DEngine->GetMaterialManager()->CloneMaterial(pSourceMaterial);
+    ++m_stats.variantsCreated;
+    if (m_warmUpComplete)
+    {
+        ++m_stats.variantsCreatedAfterWarmUp;
+    }
+
+    // The frame tile comes from the mesh texture coordinates, the row is fixed for the lifetime of the variant
+    SShaderItem& shaderItem = pVariant->GetShaderItem();
+    for (SShaderParam& param : shaderItem.m_pShaderResources->GetParameters())
+    {
+        if (strcmp(param.m_Name, "FrameX") == 0 || strcmp(param.m_Name, "FrameY") == 0)
+        {
+            param.m_Value.m_Float = 0.f;
+        }
+        if (strcmp(param.m_Name, "PaletteRow") == 0)
+        {
+            param.m_Value.m_Float = static_cast<float>(paletteRow);
+        }
+    }
+    shaderItem.m_pShaderResources->UpdateConstants(shaderItem.m_pShader);
+
+    variants.push_back({ paletteRow, pVariant, 1 });
+    return pVariant;
+}
+
+void CSpriteMaterialPool::Release(IMaterial* pVariant)
+{
+    if (!pVariant)
+    {
+        return;
+    }
+
+    const auto it = m_variants.find(pVariant->GetName());
+    if (it == m_variants.end())
+    {
+        return;
+    }
+
+    for (SVariant& variant : it->second)
+    {
+        if (variant.pMaterial == pVariant && variant.userCount > 0)
+        {
+            --variant.userCount;
+            --m_stats.users;
+            return;
+        }
+    }
+}
+
+void CSpriteMaterialPool::Clear()
+{
+    m_variants.clear();
+    m_warmUpComplete = false;
+    m_stats = SStats();
+}
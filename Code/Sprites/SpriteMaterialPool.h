@@ -0,0 +1,52 @@
+#pragma once
+
+////////////////////////////////////////////////////////
+// Shared palette variants of the sprite atlas materials
+//
+// Frames are placed by the texture coordinates of the frame meshes, so the only per-sprite
+// material state left is the palette row. Sprites showing the same atlas with the same row
+// share one clone, which is kept after its last user despawns and released in one step
+// when the level unloads.
+////////////////////////////////////////////////////////
+class CSpriteMaterialPool
+{
+public:
+    struct SStats
+    {
+        uint32 variantsCreated = 0;
+        // Variants created after the level finished loading and precaching
+        uint32 variantsCreatedAfterWarmUp = 0;
+        // Acquisitions served by an existing variant
+        uint32 variantsShared = 0;
+        uint32 users = 0;
+        uint32 peakUsers = 0;
+    };
+
+    static CSpriteMaterialPool& Get();
+
+    // Returns the variant of the atlas material for the palette row, cloning it on first use.
+    // Clones keep the name of their source, which is what the variants are keyed by.
+    _smart_ptr<IMaterial> Acquire(IMaterial* pSourceMaterial, int paletteRow);
+    void Release(IMaterial* pVariant);
+
+    void MarkWarmUpComplete() { m_warmUpComplete = true; }
+
+    // Drops every variant, called when the level unloads
+    void Clear();
+
+    const SStats& GetStats() const { return m_stats; }
+
+private:
+    struct SVariant
+    {
+        int paletteRow;
+        _smart_ptr<IMaterial> pMaterial;
+        uint32 userCount;
+    };
+
+    // A handful of palette rows per atlas, searched linearly
+    std::unordered_map<string, std::vector<SVariant>> m_variants;
+
+    bool m_warmUpComplete = false;
+    SStats m_stats;
+};
@@ -0,0 +1,99 @@
+#include "StdAfx.h"
+#include "SpriteRenderQueue.h"
+
+#include "Components/Schematyc/SpriteFlipbookComponent.h"
+
+#include <limits>
+
+CSpriteRenderQueue& CSpriteRenderQueue::Get()
+{
+    static CSpriteRenderQueue s_queue;
+    return s_queue;
+}
+
+void CSpriteRenderQueue::Register(CSpriteFlipbookComponent* pSprite)
+{
+    stl::push_back_unique(m_sprites, pSprite);
+}
+
+void CSpriteRenderQueue::Unregister(CSpriteFlipbookComponent* pSprite)
+{
+    stl::find_and_erase(m_sprites, pSprite);
+}
+
+uint16 CSpriteRenderQueue::GetAtlasId(const char* szMaterialPath)
+{
+    const auto it = m_atlasIds.find(szMaterialPath);
+    if (it != m_atlasIds.end())
+    {
+        return it->second;
+    }
+
+    // Id 0 is shared by sprites without a material and by every atlas past the last id
+    if (m_atlasIds.size() >= std::numeric_limits<uint16>::max())
+    {
+        CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Out of sprite atlas ids, %s will not be batched", szMaterialPath);
+        return 0;
+    }
+
+    const uint16 atlasId = static_cast<uint16>(m_atlasIds.size() + 1);
+    m_atlasIds.emplace(szMaterialPath, atlasId);
+    return atlasId;
+}
+
+void CSpriteRenderQueue::Update()
+{
+    if (m_sprites.empty())
+    {
+        return;
+    }
+
+    const CCamera& camera = gEnv->pSystem->GetViewCamera();
+    const Vec3 cameraPosition = camera.GetPosition();
+    const Vec3 cameraForward = camera.GetViewdir();
+
+    const uint32 spriteCount = m_sprites.size();
+    m_entries.resize(spriteCount);
+    m_viewDepths.resize(spriteCount);
+    for (uint32 i = 0; i < spriteCount; ++i)
+    {
+        const CSpriteFlipbookComponent* pSprite = m_sprites[i];
+        m_viewDepths[i] = (pSprite->GetEntity()->GetWorldPos() - cameraPosition).Dot(cameraForward);
+
+        m_entries[i].key = SpriteSort::PackKey(pSprite->GetSortLayer(), m_viewDepths[i], pSprite->GetAtlasId(), pSprite->GetSortOrder());
+        m_entries[i].index = i;
+    }
+
+    SpriteSort::RadixSort(m_entries, m_scratch);
+
+    // Sprites sharing a layer and slice are adjacent after the sort, so each group is found in one pass
+    for (uint32 groupStart = 0; groupStart < spriteCount;)
+    {
+        const uint32 group = SpriteSort::GetSliceGroup(m_entries[groupStart].key);
+        uint32 groupEnd = groupStart + 1;
+        while (groupEnd < spriteCount && SpriteSort::GetSliceGroup(m_entries[groupEnd].key) == group)
+        {
+            ++groupEnd;
+        }
+
+        // Ranks within a slice follow atlas, fine depth and sort order. Each rank gets its
+        // own depth strictly inside the slice, later ranks closer to the camera.
+        const float sliceFar = SpriteSort::GetSliceFarDepth(m_entries[groupStart].key);
+        const float rankStep = SpriteSort::kDepthSliceSize / (groupEnd - groupStart + 1);
+
+        for (uint32 i = groupStart; i < groupEnd; ++i)
+        {
+            const uint32 index = m_entries[i].index;
+            const float viewDepth = m_viewDepths[index];
+            const float targetDepth = sliceFar - rankStep * (i - groupStart + 1);
+
+            // Sprites behind the camera or beyond the last slice keep their position
+            const bool inRange = viewDepth > 0.f && viewDepth < (SpriteSort::kMaxDepthSlice + 1) * SpriteSort::kDepthSliceSize;
+            const float bias = inRange ? crymath::clamp(viewDepth - targetDepth, -SpriteSort::kDepthSliceSize, SpriteSort::kDepthSliceSize) : 0.f;
+
+            m_sprites[index]->SetSortOffset(-cameraForward * bias);
+        }
+
+        groupStart = groupEnd;
+    }
+}
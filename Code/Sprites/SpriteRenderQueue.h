@@ -0,0 +1,44 @@
+#pragma once
+
+#include "SpriteSortKey.h"
+
+class CSpriteFlipbookComponent;
+
+////////////////////////////////////////////////////////
+// Orders every registered sprite once per frame by its packed sort key
+//
+// Layers are applied as the sort priority of each sprite render node, which the renderer
+// compares before distance, so a higher layer draws on top regardless of depth. Within a
+// layer the engine sorts transparent objects by camera distance and offers no way to submit
+// them in a given order, so the resolved order is applied as an offset along the view axis.
+// Sprites sharing a layer and depth slice are spread evenly inside that slice in key order
+// (atlas, fine depth, sort order), and never leave it, so the order between slices stays
+// the one of their real depth.
+////////////////////////////////////////////////////////
+class CSpriteRenderQueue
+{
+public:
+    static CSpriteRenderQueue& Get();
+
+    void Register(CSpriteFlipbookComponent* pSprite);
+    void Unregister(CSpriteFlipbookComponent* pSprite);
+
+    // Small stable id per atlas material, used to keep sprites sharing an atlas contiguous
+    uint16 GetAtlasId(const char* szMaterialPath);
+    // Ids are only stable within a level, sprites of the next level resolve theirs again
+    void ClearAtlasIds() { m_atlasIds.clear(); }
+
+    void Update();
+
+private:
+    // In registration order, which breaks ties between equal keys
+    std::vector<CSpriteFlipbookComponent*> m_sprites;
+
+    // Rebuilt every update, their capacity is kept between frames
+    std::vector<SpriteSort::SEntry> m_entries;
+    std::vector<SpriteSort::SEntry> m_scratch;
+    // View depth of every sprite, in registration order
+    std::vector<float> m_viewDepths;
+
+    std::unordered_map<string, uint16> m_atlasIds;
+};
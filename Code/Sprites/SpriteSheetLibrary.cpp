@@ -0,0 +1,231 @@
+#include "StdAfx.h"
+#include "SpriteSheetLibrary.h"
+#include "SpriteHullLibrary.h"
+
+#include <CrySystem/File/ICryPak.h>
+
+namespace
+{
+    // Splits the next whitespace separated token off the line
+    bool NextToken(const char*& szCursor, string& token)
+    {
+        while (*szCursor == ' ' || *szCursor == '\t')
+            ++szCursor;
+
+        const char* szStart = szCursor;
+        while (*szCursor != '\0' && *szCursor != ' ' && *szCursor != '\t')
+            ++szCursor;
+
+        token.assign(szStart, szCursor);
+        return !token.empty();
+    }
+
+    bool ParseEventType(const string& type, EFlipbookEvent& eventType)
+    {
+        if (type == "hit")
+            eventType = EFlipbookEvent::Hit;
+        else if (type == "footstep")
+            eventType = EFlipbookEvent::Footstep;
+        else
+            return false;
+
+        return true;
+    }
+}
+
+CSpriteSheetLibrary& CSpriteSheetLibrary::Get()
+{
+    static CSpriteSheetLibrary s_library;
+    return s_library;
+}
+
+const SSpriteSheet* CSpriteSheetLibrary::FindOrLoad(const char* szMaterialPath)
+{
+    auto it = m_sheets.find(szMaterialPath);
+    if (it == m_sheets.end())
+    {
+        // Sheets live next to the atlas material, e.g. player.mtl -> player.spritesheet
+        const string sheetPath = PathUtil::ReplaceExtension(szMaterialPath, "spritesheet");
+        it = m_sheets.emplace(szMaterialPath, Load(sheetPath)).first;
+    }
+
+    return it->second.get();
+}
+
+std::unique_ptr<SSpriteSheet> CSpriteSheetLibrary::Load(const char* szSheetPath) const
+{
+    FILE* pFile = gEnv->pCryPak->FOpen(szSheetPath, "rb");
+    if (!pFile)
+    {
+        return nullptr;
+    }
+
+    const size_t fileSize = gEnv->pCryPak->FGetSize(pFile);
+    string contents;
+    contents.resize(fileSize);
+    gEnv->pCryPak->FReadRaw(contents.begin(), 1, fileSize, pFile);
+    gEnv->pCryPak->FClose(pFile);
+
+    std::unique_ptr<SSpriteSheet> pSheet = stl::make_unique<SSpriteSheet>();
+
+    size_t lineStart = 0;
+    string line;
+    string token;
+    std::vector<Vec2> canvasCoords;
+    std::vector<Vec2> texCoords;
+
+    while (lineStart < contents.length())
+    {
+        size_t lineEnd = contents.find('\n', lineStart);
+        if (lineEnd == string::npos)
+            lineEnd = contents.length();
+
+        line = contents.substr(lineStart, lineEnd - lineStart);
+        line.TrimRight("\r");
+        lineStart = lineEnd + 1;
+
+        const char* szCursor = line.c_str();
+        if (!NextToken(szCursor, token))
+            continue;
+
+        if (token == "atlas")
+        {
+            if (sscanf(szCursor, "%d %d %d %d", &pSheet->width, &pSheet->height, &pSheet->canvasWidth, &pSheet->canvasHeight) != 4 ||
+                pSheet->width <= 0 || pSheet->height <= 0 || pSheet->canvasWidth <= 0 || pSheet->canvasHeight <= 0)
+            {
+                CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Invalid atlas line in %s!", szSheetPath);
+                return nullptr;
+            }
+        }
+        else if (token == "stats")
+        {
+            int uniqueFrameCount = 0;
+            sscanf(szCursor, "%d %d %f", &pSheet->sourceFrameCount, &uniqueFrameCount, &pSheet->usedPixels);
+        }
+        else if (token == "frame")
+        {
+            int index = 0, x = 0, y = 0, width = 0, height = 0, canvasX = 0, canvasY = 0, vertexCount = 0;
+            int consumed = 0;
+            if (pSheet->width <= 0 ||
+                sscanf(szCursor, "%d %d %d %d %d %d %d %d%n", &index, &x, &y, &width, &height, &canvasX, &canvasY, &vertexCount, &consumed) != 8 ||
+                index < 0 || width <= 0 || height <= 0)
+            {
+                CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Skipping invalid frame line in %s", szSheetPath);
+                continue;
+            }
+            szCursor += consumed;
+
+            // Frame-local hull vertices, or the corners of the trimmed rectangle
+            canvasCoords.clear();
+            for (int i = 0; i < vertexCount; ++i)
+            {
+                Vec2 vertex;
+                if (sscanf(szCursor, "%f %f%n", &vertex.x, &vertex.y, &consumed) != 2)
+                    break;
+
+                szCursor += consumed;
+                canvasCoords.push_back(vertex);
+            }
+
+            if (canvasCoords.size() < 3)
+            {
+                canvasCoords = { Vec2(0.f, 0.f), Vec2(1.f, 0.f), Vec2(1.f, 1.f), Vec2(0.f, 1.f) };
+            }
+
+            texCoords.resize(canvasCoords.size());
+            for (size_t i = 0; i < canvasCoords.size(); ++i)
+            {
+                const Vec2 local = canvasCoords[i];
+                texCoords[i] = Vec2((x + local.x * width) / pSheet->width, (y + local.y * height) / pSheet->height);
+                canvasCoords[i] = Vec2((canvasX + local.x * width) / pSheet->canvasWidth, (canvasY + local.y * height) / pSheet->canvasHeight);
+            }
+
+            if (index >= (int)pSheet->frames.size())
+            {
+                pSheet->frames.resize(index + 1);
+            }
+            pSheet->frames[index] = CSpriteHullLibrary::CreateFrameMesh(canvasCoords.data(), texCoords.data(), (int)canvasCoords.size());
+        }
+        else if (token == "clip")
+        {
+            SSpriteSheet::SClip clip;
+            int loop = 0, frameCount = 0, consumed = 0;
+            if (!NextToken(szCursor, clip.name) ||
+                sscanf(szCursor, "%f %d %d%n", &clip.anim.fps, &loop, &frameCount, &consumed) != 3 || frameCount <= 0)
+            {
+                CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Skipping invalid clip line in %s", szSheetPath);
+                continue;
+            }
+            szCursor += consumed;
+
+            clip.anim.startFrame = (int)pSheet->sequence.size();
+            clip.anim.endFrame = clip.anim.startFrame + frameCount - 1;
+            clip.anim.row = 0;
+            clip.anim.loop = loop != 0;
+
+            for (int i = 0; i < frameCount; ++i)
+            {
+                int frame = -1;
+                if (sscanf(szCursor, "%d%n", &frame, &consumed) == 1)
+                    szCursor += consumed;
+
+                pSheet->sequence.push_back(frame);
+            }
+
+            pSheet->clips.push_back(std::move(clip));
+        }
+        else if (token == "event")
+        {
+            string clipName;
+            string frame;
+            string type;
+            SFlipbookEventMarker marker;
+            if (!NextToken(szCursor, clipName) || !NextToken(szCursor, frame) || !NextToken(szCursor, type) || !ParseEventType(type, marker.type))
+            {
+                CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Skipping invalid event line in %s", szSheetPath);
+                continue;
+            }
+            marker.frame = atoi(frame.c_str());
+
+            for (SSpriteSheet::SClip& clip : pSheet->clips)
+            {
+                if (clip.name != clipName)
+                    continue;
+
+                // Markers are relative to the first frame of the clip, one past its end would never fire
+                if (marker.frame < 0 || marker.frame >= clip.anim.GetFrameCount())
+                {
+                    CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Skipping event on frame %d of the %d frame clip %s in %s",
+                        marker.frame, clip.anim.GetFrameCount(), clipName.c_str(), szSheetPath);
+                    continue;
+                }
+
+                clip.markers.push_back(marker);
+            }
+        }
+    }
+
+    if (pSheet->frames.empty() || pSheet->clips.empty())
+    {
+        CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "No frames or clips found in %s!", szSheetPath);
+        return nullptr;
+    }
+
+    // Sequence entries that don't name a packed frame fall back to the full quad
+    for (int& frame : pSheet->sequence)
+    {
+        if (frame < 0 || frame >= (int)pSheet->frames.size())
+            frame = -1;
+    }
+
+    // The clips no longer move, so the plain data views can point into them
+    for (SSpriteSheet::SClip& clip : pSheet->clips)
+    {
+        clip.anim.name = clip.name.c_str();
+        clip.anim.markers = clip.markers.empty() ? nullptr : clip.markers.data();
+        clip.anim.markerCount = (int)clip.markers.size();
+    }
+
+    CryLog("[SpriteSheet] Loaded %s: %" PRISIZE_T " frames, %" PRISIZE_T " clips", szSheetPath, pSheet->frames.size(), pSheet->clips.size());
+    return pSheet;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Cry3DEngine/IStatObj.h>
+
+#include "Components/Schematyc/FFlipbookAnim.h"
+
+////////////////////////////////////////////////////////
+// Packed atlases and clip tables generated offline by SpriteSheetPacker
+//
+// Frames of a packed atlas have no grid, each one is drawn through its own mesh whose
+// texture coordinates point straight into the atlas. Clips play ranges of the sequence,
+// which lists the frames of every clip back to back.
+////////////////////////////////////////////////////////
+struct SSpriteSheet
+{
+    struct SClip
+    {
+        string name;
+        std::vector<SFlipbookEventMarker> markers;
+        // Name and markers point into this clip
+        FFlipbookAnim anim = {};
+    };
+
+    int width = 0;
+    int height = 0;
+    int canvasWidth = 0;
+    int canvasHeight = 0;
+
+    // As reported by the packer
+    int sourceFrameCount = 0;
+    float usedPixels = 0.f;
+
+    std::vector<_smart_ptr<IStatObj>> frames;
+    std::vector<int> sequence;
+    std::vector<SClip> clips;
+
+    const FFlipbookAnim* FindClip(const char* szName) const
+    {
+        for (const SClip& clip : clips)
+        {
+            if (clip.anim.IsClip(szName))
+                return &clip.anim;
+        }
+
+        return nullptr;
+    }
+
+    IStatObj* GetSequenceFrame(int index) const
+    {
+        if (index < 0 || index >= (int)sequence.size() || sequence[index] < 0)
+            return nullptr;
+
+        return frames[sequence[index]];
+    }
+};
+
+class CSpriteSheetLibrary
+{
+public:
+    static CSpriteSheetLibrary& Get();
+
+    // Returns the sheet packed for the atlas material, or null when it is a hand-authored grid
+    const SSpriteSheet* FindOrLoad(const char* szMaterialPath);
+
+    void Clear() { m_sheets.clear(); }
+
+private:
+    std::unique_ptr<SSpriteSheet> Load(const char* szSheetPath) const;
+
+    // Keyed by material path, holds null for grid atlases so the lookup is only done once
+    std::unordered_map<string, std::unique_ptr<SSpriteSheet>> m_sheets;
+};
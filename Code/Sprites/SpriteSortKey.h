@@ -0,0 +1,120 @@
+#pragma once
+
+// Kept free of engine types so the sort can be benchmarked headless by SpriteSortBenchmark
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////
+// Packed 64-bit sprite sort keys, sorted ascending means drawn first
+//   [63..56] layer        higher layers draw on top
+//   [55..40] depth slice  coarse view depth, inverted so that far slices draw first
+//   [39..24] atlas        sprites of a slice that share an atlas are contiguous
+//   [23..16] fine depth   position inside the slice, inverted
+//   [15..0]  sub-order    designer tie-break
+//
+// Atlas ranks above fine depth so that batches form: inside one slice, sprites are
+// grouped by atlas first and only then ordered back to front.
+////////////////////////////////////////////////////////
+namespace SpriteSort
+{
+    constexpr int kDepthBits = 24;
+    constexpr int kFineDepthBits = 8;
+    constexpr uint32_t kMaxDepthValue = (1u << kDepthBits) - 1;
+    constexpr uint32_t kMaxDepthSlice = kMaxDepthValue >> kFineDepthBits;
+    // View depth covered by one slice, sprites closer than this along the view axis may be reordered by atlas
+    constexpr float kDepthSliceSize = 1.f / 4.f;
+    constexpr float kDepthQuantum = kDepthSliceSize / float(1u << kFineDepthBits);
+
+    struct SEntry
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    inline uint64_t PackKey(uint8_t layer, float viewDepth, uint16_t atlasId, uint16_t subOrder)
+    {
+        const float clampedDepth = viewDepth > 0.f ? viewDepth / kDepthQuantum : 0.f;
+        const uint32_t depth = clampedDepth >= float(kMaxDepthValue) ? kMaxDepthValue : uint32_t(clampedDepth);
+        const uint32_t invertedDepth = kMaxDepthValue - depth;
+
+        return uint64_t(layer) << 56 |
+            uint64_t(invertedDepth >> kFineDepthBits) << 40 |
+            uint64_t(atlasId) << 24 |
+            uint64_t(invertedDepth & ((1u << kFineDepthBits) - 1)) << 16 |
+            uint64_t(subOrder);
+    }
+
+    inline uint8_t GetLayer(uint64_t key) { return uint8_t(key >> 56); }
+    inline uint16_t GetAtlasId(uint64_t key) { return uint16_t(key >> 24); }
+    // Layer and depth slice, sprites sharing it are spread inside the slice in key order
+    inline uint32_t GetSliceGroup(uint64_t key) { return uint32_t(key >> 40); }
+    // Batch the sprite belongs to, every batch is one contiguous run of the sorted keys
+    inline uint64_t GetBatch(uint64_t key) { return key >> 24; }
+
+    // View depth of the far edge of the slice
+    inline float GetSliceFarDepth(uint64_t key)
+    {
+        return float(kMaxDepthSlice - (GetSliceGroup(key) & kMaxDepthSlice) + 1) * kDepthSliceSize;
+    }
+
+    // Stable LSD radix sort on 8-bit digits, linear in the number of entries.
+    // Digits that are the same for every entry are skipped, so a frame where only
+    // a few key bits vary costs only a few passes. Equal keys keep their input order.
+    inline void RadixSort(std::vector<SEntry>& entries, std::vector<SEntry>& scratch)
+    {
+        constexpr int kDigitBits = 8;
+        constexpr int kDigitCount = 64 / kDigitBits;
+        constexpr int kBucketCount = 1 << kDigitBits;
+
+        const size_t count = entries.size();
+        if (count < 2)
+            return;
+
+        // Histograms of every digit in a single read of the keys
+        uint32_t histograms[kDigitCount][kBucketCount] = {};
+        for (const SEntry& entry : entries)
+        {
+            for (int digit = 0; digit < kDigitCount; ++digit)
+            {
+                ++histograms[digit][(entry.key >> (digit * kDigitBits)) & (kBucketCount - 1)];
+            }
+        }
+
+        scratch.resize(count);
+        SEntry* pSource = entries.data();
+        SEntry* pDestination = scratch.data();
+
+        for (int digit = 0; digit < kDigitCount; ++digit)
+        {
+            uint32_t* pHistogram = histograms[digit];
+            const int shift = digit * kDigitBits;
+
+            if (pHistogram[(pSource[0].key >> shift) & (kBucketCount - 1)] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (int bucket = 0; bucket < kBucketCount; ++bucket)
+            {
+                const uint32_t bucketSize = pHistogram[bucket];
+                pHistogram[bucket] = offset;
+                offset += bucketSize;
+            }
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const SEntry& entry = pSource[i];
+                pDestination[pHistogram[(entry.key >> shift) & (kBucketCount - 1)]++] = entry;
+            }
+
+            SEntry* pSwap = pSource;
+            pSource = pDestination;
+            pDestination = pSwap;
+        }
+
+        if (pSource != entries.data())
+        {
+            entries.swap(scratch);
+        }
+    }
+}
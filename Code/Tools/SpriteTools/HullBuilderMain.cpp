@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////
+// Offline step that generates a .spritehull file for a uniform grid atlas
+// Usage: SpriteHullBuilder <atlas.tga> <tilesX> <tilesY> <output.spritehull> [options]
+////////////////////////////////////////////////////////
+#include "Image.h"
+#include "SpriteHull.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::printf(
+            "Usage: SpriteHullBuilder <atlas.tga> <tilesX> <tilesY> <output.spritehull> [options]\n"
+            "Options:\n"
+            "  --alpha-threshold <0-255>  Pixels with a higher alpha are kept inside the hull (default 0)\n"
+            "  --max-vertices <n>         Maximum vertices per frame hull (default 8)\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 5)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const char* szAtlasPath = argv[1];
+    const int tilesX = std::atoi(argv[2]);
+    const int tilesY = std::atoi(argv[3]);
+    const char* szOutputPath = argv[4];
+
+    SHullSettings settings;
+    for (int i = 5; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--alpha-threshold") == 0 && i + 1 < argc)
+        {
+            settings.alphaThreshold = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--max-vertices") == 0 && i + 1 < argc)
+        {
+            settings.maxVertices = std::atoi(argv[++i]);
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (tilesX <= 0 || tilesY <= 0)
+    {
+        std::fprintf(stderr, "Tile counts must be positive\n");
+        return 1;
+    }
+
+    std::string error;
+    SImage atlas;
+    if (!LoadTga(szAtlasPath, atlas, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    if (atlas.width % tilesX != 0 || atlas.height % tilesY != 0)
+    {
+        std::fprintf(stderr, "Warning: %dx%d atlas is not evenly divisible into %dx%d tiles\n", atlas.width, atlas.height, tilesX, tilesY);
+    }
+
+    const SAtlasHulls hulls = BuildAtlasHulls(atlas, tilesX, tilesY, settings);
+    if (!SaveAtlasHulls(szOutputPath, hulls, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    // Overdraw report: pixels shaded by the full quads versus the hulls, and how many of them are actually visible
+    std::printf("Atlas %s: %zu frames\n", szAtlasPath, hulls.frames.size());
+    std::printf("  Quad pixels:   %.0f\n", hulls.quadPixels);
+    std::printf("  Hull pixels:   %.0f (%.1f%% of quad)\n", hulls.hullPixels, 100.0 * hulls.hullPixels / hulls.quadPixels);
+    std::printf("  Opaque pixels: %.0f (%.1f%% of quad)\n", hulls.opaquePixels, 100.0 * hulls.opaquePixels / hulls.quadPixels);
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "Image.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+    enum ETgaImageType : uint8_t
+    {
+        eTgaImageType_TrueColor = 2,
+        eTgaImageType_TrueColorRle = 10
+    };
+
+    // Bit 5 of the descriptor is set when rows are stored top to bottom
+    constexpr uint8_t kTgaTopLeftOrigin = 1 << 5;
+
+    constexpr size_t kTgaHeaderSize = 18;
+
+    uint32_t ReadBgra(const uint8_t* pData, int bytesPerPixel)
+    {
+        const uint32_t alpha = bytesPerPixel == 4 ? pData[3] : 0xFF;
+        return uint32_t(pData[2]) | uint32_t(pData[1]) << 8 | uint32_t(pData[0]) << 16 | alpha << 24;
+    }
+}
+
+bool LoadTga(const std::string& path, SImage& image, std::string& error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < kTgaHeaderSize)
+    {
+        error = "Truncated TGA header in " + path;
+        return false;
+    }
+
+    const uint8_t idLength = data[0];
+    const uint8_t colorMapType = data[1];
+    const uint8_t imageType = data[2];
+    const int width = data[12] | data[13] << 8;
+    const int height = data[14] | data[15] << 8;
+    const int bitsPerPixel = data[16];
+    const uint8_t descriptor = data[17];
+
+    if (colorMapType != 0 || (imageType != eTgaImageType_TrueColor && imageType != eTgaImageType_TrueColorRle))
+    {
+        error = "Unsupported TGA image type in " + path + ", expected true-colour";
+        return false;
+    }
+
+    if (bitsPerPixel != 24 && bitsPerPixel != 32)
+    {
+        error = "Unsupported TGA pixel depth in " + path + ", expected 24 or 32 bits";
+        return false;
+    }
+
+    const int bytesPerPixel = bitsPerPixel / 8;
+    const size_t pixelCount = size_t(width) * height;
+
+    std::vector<uint32_t> decoded;
+    decoded.reserve(pixelCount);
+
+    size_t offset = kTgaHeaderSize + idLength;
+    while (decoded.size() < pixelCount)
+    {
+        if (imageType == eTgaImageType_TrueColor)
+        {
+            if (offset + bytesPerPixel > data.size())
+                break;
+
+            decoded.push_back(ReadBgra(&data[offset], bytesPerPixel));
+            offset += bytesPerPixel;
+            continue;
+        }
+
+        if (offset >= data.size())
+            break;
+
+        // RLE packets: the high bit selects a repeated pixel, the low bits hold the count minus one
+        const uint8_t packet = data[offset++];
+        const size_t count = (packet & 0x7F) + 1;
+        if (packet & 0x80)
+        {
+            if (offset + bytesPerPixel > data.size())
+                break;
+
+            const uint32_t pixel = ReadBgra(&data[offset], bytesPerPixel);
+            offset += bytesPerPixel;
+            decoded.insert(decoded.end(), count, pixel);
+        }
+        else
+        {
+            for (size_t i = 0; i < count && offset + bytesPerPixel <= data.size(); ++i)
+            {
+                decoded.push_back(ReadBgra(&data[offset], bytesPerPixel));
+                offset += bytesPerPixel;
+            }
+        }
+    }
+
+    if (decoded.size() < pixelCount)
+    {
+        error = "Truncated TGA pixel data in " + path;
+        return false;
+    }
+    decoded.resize(pixelCount);
+
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(pixelCount);
+
+    const bool topLeftOrigin = (descriptor & kTgaTopLeftOrigin) != 0;
+    for (int y = 0; y < height; ++y)
+    {
+        const int sourceRow = topLeftOrigin ? y : height - 1 - y;
+        std::copy_n(&decoded[size_t(sourceRow) * width], width, &image.pixels[size_t(y) * width]);
+    }
+
+    return true;
+}
+
+bool SaveTga(const std::string& path, const SImage& image, std::string& error)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        error = "Failed to create " + path;
+        return false;
+    }
+
+    uint8_t header[kTgaHeaderSize] = {};
+    header[2] = eTgaImageType_TrueColor;
+    header[12] = uint8_t(image.width);
+    header[13] = uint8_t(image.width >> 8);
+    header[14] = uint8_t(image.height);
+    header[15] = uint8_t(image.height >> 8);
+    header[16] = 32;
+    header[17] = kTgaTopLeftOrigin | 8; // 8 alpha bits
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    std::vector<uint8_t> bgra(image.pixels.size() * 4);
+    for (size_t i = 0; i < image.pixels.size(); ++i)
+    {
+        const uint32_t pixel = image.pixels[i];
+        bgra[i * 4 + 0] = uint8_t(pixel >> 16);
+        bgra[i * 4 + 1] = uint8_t(pixel >> 8);
+        bgra[i * 4 + 2] = uint8_t(pixel);
+        bgra[i * 4 + 3] = uint8_t(pixel >> 24);
+    }
+    file.write(reinterpret_cast<const char*>(bgra.data()), bgra.size());
+
+    if (!file)
+    {
+        error = "Failed to write " + path;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////
+// 32-bit RGBA image with a top-left origin
+////////////////////////////////////////////////////////
+struct SImage
+{
+    int width = 0;
+    int height = 0;
+    // One RGBA8 value per pixel, red in the lowest byte
+    std::vector<uint32_t> pixels;
+
+    uint32_t GetPixel(int x, int y) const { return pixels[size_t(y) * width + x]; }
+    uint8_t GetAlpha(int x, int y) const { return uint8_t(GetPixel(x, y) >> 24); }
+};
+
+// Loads an uncompressed or RLE compressed 24/32-bit TGA
+bool LoadTga(const std::string& path, SImage& image, std::string& error);
+// Saves an uncompressed 32-bit TGA
+bool SaveTga(const std::string& path, const SImage& image, std::string& error);
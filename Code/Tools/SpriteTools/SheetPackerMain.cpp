@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////
+// Offline step that packs folders of frame images into one atlas and its .spritesheet clip table
+// Usage: SpriteSheetPacker <clips.manifest> <output.tga> <output.spritesheet> [options]
+////////////////////////////////////////////////////////
+#include "Image.h"
+#include "SpriteSheet.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    void PrintUsage()
+    {
+        std::printf(
+            "Usage: SpriteSheetPacker <clips.manifest> <output.tga> <output.spritesheet> [options]\n"
+            "Options:\n"
+            "  --alpha-threshold <0-255>  Pixels with a higher alpha are kept when trimming (default 0)\n"
+            "  --padding <pixels>         Space between frames, filled by extruding their edges (default 2)\n"
+            "  --max-size <pixels>        Maximum atlas width and height (default 8192)\n"
+            "  --npot                     Allow atlas sizes that are not powers of two\n"
+            "  --max-vertices <n>         Maximum vertices per frame hull, 0 draws trimmed rectangles (default 8)\n"
+            "  --threads <n>              Worker threads, 0 uses every core (default 0)\n");
+    }
+
+    double SecondsSince(const Clock::time_point& start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const char* szManifestPath = argv[1];
+    const char* szAtlasPath = argv[2];
+    const char* szSheetPath = argv[3];
+
+    SPackSettings settings;
+    for (int i = 4; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--alpha-threshold") == 0 && i + 1 < argc)
+        {
+            settings.alphaThreshold = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--padding") == 0 && i + 1 < argc)
+        {
+            settings.padding = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--max-size") == 0 && i + 1 < argc)
+        {
+            settings.maxAtlasSize = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--npot") == 0)
+        {
+            settings.powerOfTwo = false;
+        }
+        else if (std::strcmp(argv[i], "--max-vertices") == 0 && i + 1 < argc)
+        {
+            settings.maxHullVertices = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            settings.threadCount = std::atoi(argv[++i]);
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (settings.padding < 0 || settings.maxAtlasSize <= 0)
+    {
+        std::fprintf(stderr, "Padding must not be negative and the maximum size must be positive\n");
+        return 1;
+    }
+
+    const Clock::time_point startTime = Clock::now();
+
+    std::string error;
+    std::vector<SClipDesc> clips;
+    if (!LoadClipManifest(szManifestPath, clips, error) || !GatherClipFrames(szManifestPath, clips, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    // Every clip frame gets its own slot, frames shared between clips are merged by the deduplication
+    std::vector<std::string> framePaths;
+    for (const SClipDesc& clip : clips)
+    {
+        framePaths.insert(framePaths.end(), clip.framePaths.begin(), clip.framePaths.end());
+    }
+
+    std::vector<STrimmedFrame> frames(framePaths.size());
+    std::atomic<bool> failed(false);
+    std::mutex errorMutex;
+
+    ParallelFor(framePaths.size(), settings.threadCount, [&](size_t i)
+    {
+        std::string frameError;
+        SImage image;
+        if (!LoadTga(framePaths[i], image, frameError))
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            error = frameError;
+            failed = true;
+            return;
+        }
+
+        frames[i] = TrimFrame(image, settings.alphaThreshold);
+    });
+
+    if (failed)
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    const double loadSeconds = SecondsSince(startTime);
+
+    std::vector<int> uniqueFrames;
+    const std::vector<int> frameRemap = DeduplicateFrames(frames, uniqueFrames);
+
+    SSpriteSheet sheet;
+    if (!PackSpriteSheet(frames, uniqueFrames, settings, sheet, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    size_t sourceIndex = 0;
+    for (const SClipDesc& clip : clips)
+    {
+        std::vector<int> clipFrames;
+        for (size_t i = 0; i < clip.framePaths.size(); ++i)
+        {
+            clipFrames.push_back(frameRemap[sourceIndex++]);
+        }
+        sheet.clipFrames.push_back(std::move(clipFrames));
+    }
+
+    BuildSheetHulls(frames, settings, sheet);
+
+    const double packSeconds = SecondsSince(startTime) - loadSeconds;
+
+    const SImage atlas = ComposeAtlas(frames, sheet, settings);
+    if (!SaveTga(szAtlasPath, atlas, error) || !SaveSpriteSheet(szSheetPath, sheet, frames, clips, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    // Efficiency report: how much of the atlas holds frame pixels, and what trimming and deduplication saved
+    uint64_t sourcePixels = 0;
+    for (const STrimmedFrame& frame : frames)
+    {
+        sourcePixels += uint64_t(frame.sourceWidth) * frame.sourceHeight;
+    }
+
+    const double atlasPixels = double(sheet.width) * sheet.height;
+
+    std::printf("Sprite sheet %s: %zu clips, %zu frames\n", szSheetPath, clips.size(), frames.size());
+    std::printf("  Unique frames:   %zu (%zu duplicates removed)\n", uniqueFrames.size(), frames.size() - uniqueFrames.size());
+    std::printf("  Atlas:           %dx%d\n", sheet.width, sheet.height);
+    std::printf("  Source pixels:   %llu\n", static_cast<unsigned long long>(sourcePixels));
+    std::printf("  Packed pixels:   %llu (%.1f%% of source)\n", static_cast<unsigned long long>(sheet.usedPixels), 100.0 * sheet.usedPixels / double(sourcePixels));
+    std::printf("  Efficiency:      %.1f%% of the atlas holds frame pixels\n", 100.0 * sheet.usedPixels / atlasPixels);
+    std::printf("  Time:            %.2fs load, %.2fs pack, %.2fs total\n", loadSeconds, packSeconds, SecondsSince(startTime));
+
+    return 0;
+}
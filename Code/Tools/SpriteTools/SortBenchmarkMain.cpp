@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////
+// Headless benchmark of the per-frame sprite sort
+// Usage: SpriteSortBenchmark [maxSprites] [iterations]
+////////////////////////////////////////////////////////
+#include "Sprites/SpriteSortKey.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_set>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Sprites spread over a few layers and atlases, with depths like a side-scrolling level
+    std::vector<SpriteSort::SEntry> MakeFrame(size_t spriteCount, std::mt19937& random)
+    {
+        std::uniform_int_distribution<int> layer(0, 3);
+        std::uniform_real_distribution<float> depth(0.f, 100.f);
+        std::uniform_int_distribution<int> atlas(0, 31);
+        std::uniform_int_distribution<int> subOrder(0, 15);
+
+        std::vector<SpriteSort::SEntry> entries(spriteCount);
+        for (size_t i = 0; i < spriteCount; ++i)
+        {
+            entries[i].key = SpriteSort::PackKey(uint8_t(layer(random)), depth(random), uint16_t(atlas(random)), uint16_t(subOrder(random)));
+            entries[i].index = uint32_t(i);
+        }
+        return entries;
+    }
+
+    // Runs of consecutive sprites sharing layer, depth slice and atlas, each one a potential batch
+    size_t CountBatchRuns(const std::vector<SpriteSort::SEntry>& entries)
+    {
+        size_t runs = 0;
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            if (i == 0 || SpriteSort::GetBatch(entries[i].key) != SpriteSort::GetBatch(entries[i - 1].key))
+                ++runs;
+        }
+        return runs;
+    }
+
+    size_t CountBatches(const std::vector<SpriteSort::SEntry>& entries)
+    {
+        std::unordered_set<uint64_t> batches;
+        for (const SpriteSort::SEntry& entry : entries)
+        {
+            batches.insert(SpriteSort::GetBatch(entry.key));
+        }
+        return batches.size();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t maxSprites = argc > 1 ? size_t(std::atoll(argv[1])) : 500000;
+    const int iterations = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 20;
+
+    std::mt19937 random(1234);
+
+    std::printf("%10s %14s %14s %14s %12s\n", "sprites", "radix ns/spr", "stable ns/spr", "speedup", "batch runs");
+
+    std::vector<SpriteSort::SEntry> scratch;
+    for (size_t spriteCount = 1000; spriteCount <= maxSprites; spriteCount *= 10)
+    {
+        const std::vector<SpriteSort::SEntry> frame = MakeFrame(spriteCount, random);
+
+        double radixSeconds = 0.0;
+        double stableSeconds = 0.0;
+        std::vector<SpriteSort::SEntry> radixSorted;
+        std::vector<SpriteSort::SEntry> stableSorted;
+
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            radixSorted = frame;
+            const Clock::time_point radixStart = Clock::now();
+            SpriteSort::RadixSort(radixSorted, scratch);
+            radixSeconds += std::chrono::duration<double>(Clock::now() - radixStart).count();
+
+            stableSorted = frame;
+            const Clock::time_point stableStart = Clock::now();
+            std::stable_sort(stableSorted.begin(), stableSorted.end(), [](const SpriteSort::SEntry& a, const SpriteSort::SEntry& b)
+            {
+                return a.key < b.key;
+            });
+            stableSeconds += std::chrono::duration<double>(Clock::now() - stableStart).count();
+        }
+
+        // Both sorts are stable, so they have to agree on the index order as well
+        for (size_t i = 0; i < spriteCount; ++i)
+        {
+            if (radixSorted[i].key != stableSorted[i].key || radixSorted[i].index != stableSorted[i].index)
+            {
+                std::fprintf(stderr, "Radix sort mismatch at %zu for %zu sprites\n", i, spriteCount);
+                return 1;
+            }
+        }
+
+        // Every batch has to be a single run, a batch split by fine depth or sub-order costs a draw call
+        const size_t runs = CountBatchRuns(radixSorted);
+        const size_t batches = CountBatches(radixSorted);
+        if (runs != batches)
+        {
+            std::fprintf(stderr, "%zu batch runs for %zu batches with %zu sprites\n", runs, batches, spriteCount);
+            return 1;
+        }
+
+        const double radixNs = radixSeconds * 1e9 / (double(iterations) * spriteCount);
+        const double stableNs = stableSeconds * 1e9 / (double(iterations) * spriteCount);
+        std::printf("%10zu %14.2f %14.2f %13.2fx %12zu\n", spriteCount, radixNs, stableNs, stableNs / radixNs, runs);
+
+        if (spriteCount < maxSprites && spriteCount * 10 > maxSprites)
+        {
+            spriteCount = maxSprites / 10;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include "SpriteHull.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace
+{
+    double Cross(const SHullVertex& o, const SHullVertex& a, const SHullVertex& b)
+    {
+        return double(a.x - o.x) * (b.y - o.y) - double(a.y - o.y) * (b.x - o.x);
+    }
+
+    double PolygonArea(const std::vector<SHullVertex>& polygon)
+    {
+        double area = 0.0;
+        for (size_t i = 0, count = polygon.size(); i < count; ++i)
+        {
+            const SHullVertex& a = polygon[i];
+            const SHullVertex& b = polygon[(i + 1) % count];
+            area += double(a.x) * b.y - double(b.x) * a.y;
+        }
+        return std::abs(area) * 0.5;
+    }
+
+    // Andrew's monotone chain, returns the hull without collinear points
+    std::vector<SHullVertex> ConvexHull(std::vector<SHullVertex> points)
+    {
+        std::sort(points.begin(), points.end(), [](const SHullVertex& a, const SHullVertex& b)
+        {
+            return a.x < b.x || (a.x == b.x && a.y < b.y);
+        });
+
+        if (points.size() < 3)
+            return points;
+
+        std::vector<SHullVertex> hull(points.size() * 2);
+        size_t count = 0;
+
+        for (const SHullVertex& point : points)
+        {
+            while (count >= 2 && Cross(hull[count - 2], hull[count - 1], point) <= 0.0)
+                --count;
+            hull[count++] = point;
+        }
+
+        for (size_t i = points.size() - 1, lowerCount = count + 1; i-- > 0;)
+        {
+            while (count >= lowerCount && Cross(hull[count - 2], hull[count - 1], points[i]) <= 0.0)
+                --count;
+            hull[count++] = points[i];
+        }
+
+        hull.resize(count - 1);
+        return hull;
+    }
+
+    // Removes edges by extending their neighbours until they meet, which only ever grows the polygon,
+    // so every opaque pixel stays covered. Picks the edge that adds the least area each time.
+    void ReduceHull(std::vector<SHullVertex>& hull, int maxVertices, float width, float height)
+    {
+        const int minVertices = std::max(maxVertices, 3);
+
+        while (int(hull.size()) > minVertices)
+        {
+            const size_t count = hull.size();
+            double bestArea = std::numeric_limits<double>::max();
+            size_t bestEdge = count;
+            SHullVertex bestPoint = {};
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const SHullVertex& prev = hull[(i + count - 1) % count];
+                const SHullVertex& a = hull[i];
+                const SHullVertex& b = hull[(i + 1) % count];
+                const SHullVertex& next = hull[(i + 2) % count];
+
+                const double d1x = a.x - prev.x, d1y = a.y - prev.y;
+                const double d2x = b.x - next.x, d2y = b.y - next.y;
+                const double denominator = d1x * d2y - d1y * d2x;
+                if (std::abs(denominator) < 1e-9)
+                    continue;
+
+                // Both neighbouring edges have to be extended forwards to meet beyond the removed edge
+                const double t = ((b.x - a.x) * d2y - (b.y - a.y) * d2x) / denominator;
+                const double s = ((b.x - a.x) * d1y - (b.y - a.y) * d1x) / denominator;
+                if (t <= 0.0 || s <= 0.0)
+                    continue;
+
+                const SHullVertex point = { float(a.x + d1x * t), float(a.y + d1y * t) };
+                if (point.x < 0.f || point.y < 0.f || point.x > width || point.y > height)
+                    continue;
+
+                const double addedArea = std::abs(Cross(a, point, b)) * 0.5;
+                if (addedArea < bestArea)
+                {
+                    bestArea = addedArea;
+                    bestEdge = i;
+                    bestPoint = point;
+                }
+            }
+
+            if (bestEdge == count)
+                break;
+
+            hull[bestEdge] = bestPoint;
+            hull.erase(hull.begin() + (bestEdge + 1) % count);
+        }
+    }
+}
+
+SFrameHull BuildFrameHull(const SImage& image, int left, int top, int width, int height, const SHullSettings& settings)
+{
+    SFrameHull frame;
+
+    // The outer corners of the first and last opaque pixel of each row are enough to span the hull
+    std::vector<SHullVertex> points;
+    points.reserve(size_t(height) * 4);
+
+    for (int y = 0; y < height; ++y)
+    {
+        int minX = width;
+        int maxX = -1;
+
+        for (int x = 0; x < width; ++x)
+        {
+            if (image.GetAlpha(left + x, top + y) > settings.alphaThreshold)
+            {
+                minX = std::min(minX, x);
+                maxX = x;
+                ++frame.opaquePixels;
+            }
+        }
+
+        if (maxX < 0)
+            continue;
+
+        points.push_back({ float(minX), float(y) });
+        points.push_back({ float(minX), float(y + 1) });
+        points.push_back({ float(maxX + 1), float(y) });
+        points.push_back({ float(maxX + 1), float(y + 1) });
+    }
+
+    if (points.empty())
+        return frame;
+
+    frame.vertices = ConvexHull(std::move(points));
+    ReduceHull(frame.vertices, settings.maxVertices, float(width), float(height));
+    frame.hullPixels = PolygonArea(frame.vertices);
+
+    return frame;
+}
+
+SAtlasHulls BuildAtlasHulls(const SImage& image, int tilesX, int tilesY, const SHullSettings& settings)
+{
+    SAtlasHulls hulls;
+    hulls.width = image.width;
+    hulls.height = image.height;
+    hulls.tilesX = tilesX;
+    hulls.tilesY = tilesY;
+
+    const int frameWidth = image.width / tilesX;
+    const int frameHeight = image.height / tilesY;
+
+    for (int row = 0; row < tilesY; ++row)
+    {
+        for (int column = 0; column < tilesX; ++column)
+        {
+            SFrameHull frame = BuildFrameHull(image, column * frameWidth, row * frameHeight, frameWidth, frameHeight, settings);
+            frame.column = column;
+            frame.row = row;
+
+            hulls.quadPixels += double(frameWidth) * frameHeight;
+            hulls.hullPixels += frame.hullPixels;
+            hulls.opaquePixels += frame.opaquePixels;
+            hulls.frames.push_back(std::move(frame));
+        }
+    }
+
+    return hulls;
+}
+
+bool SaveAtlasHulls(const std::string& path, const SAtlasHulls& hulls, std::string& error)
+{
+    FILE* pFile = std::fopen(path.c_str(), "w");
+    if (!pFile)
+    {
+        error = "Failed to create " + path;
+        return false;
+    }
+
+    const float frameWidth = float(hulls.width / hulls.tilesX);
+    const float frameHeight = float(hulls.height / hulls.tilesY);
+
+    std::fprintf(pFile, "spritehull 1\n");
+    std::fprintf(pFile, "atlas %d %d %d %d\n", hulls.width, hulls.height, hulls.tilesX, hulls.tilesY);
+    std::fprintf(pFile, "stats %.0f %.0f %.0f\n", hulls.quadPixels, hulls.hullPixels, hulls.opaquePixels);
+
+    for (const SFrameHull& frame : hulls.frames)
+    {
+        std::fprintf(pFile, "frame %d %d %d", frame.column, frame.row, int(frame.vertices.size()));
+        for (const SHullVertex& vertex : frame.vertices)
+        {
+            std::fprintf(pFile, " %.5f %.5f", vertex.x / frameWidth, vertex.y / frameHeight);
+        }
+        std::fprintf(pFile, "\n");
+    }
+
+    const bool succeeded = std::ferror(pFile) == 0;
+    std::fclose(pFile);
+
+    if (!succeeded)
+    {
+        error = "Failed to write " + path;
+        return false;
+    }
+
+    return true;
+}
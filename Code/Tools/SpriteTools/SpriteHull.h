@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Image.h"
+
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////
+// Tight convex polygons around the opaque pixels of atlas frames
+//
+// Hulls are written as a text .spritehull file next to the atlas material:
+//   spritehull 1
+//   atlas <width> <height> <tilesX> <tilesY>
+//   stats <quadPixels> <hullPixels> <opaquePixels>
+//   frame <column> <row> <vertexCount> <u0> <v0> <u1> <v1> ...
+// Vertices are in frame-local UV space (0..1, v down) and wound consistently.
+// A frame with no vertices has no opaque pixels.
+////////////////////////////////////////////////////////
+struct SHullVertex
+{
+    float x;
+    float y;
+};
+
+struct SFrameHull
+{
+    int column = 0;
+    int row = 0;
+    // Frame-local pixel coordinates
+    std::vector<SHullVertex> vertices;
+
+    int opaquePixels = 0;
+    double hullPixels = 0.0;
+};
+
+struct SHullSettings
+{
+    // Pixels with an alpha above this value are kept inside the hull
+    int alphaThreshold = 0;
+    // Hulls are grown outwards until they have at most this many vertices
+    int maxVertices = 8;
+};
+
+struct SAtlasHulls
+{
+    int width = 0;
+    int height = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    std::vector<SFrameHull> frames;
+
+    double quadPixels = 0.0;
+    double hullPixels = 0.0;
+    double opaquePixels = 0.0;
+};
+
+// Builds the hull of the frame occupying the given pixel rectangle
+SFrameHull BuildFrameHull(const SImage& image, int left, int top, int width, int height, const SHullSettings& settings);
+// Builds the hulls of every frame of a uniform grid atlas
+SAtlasHulls BuildAtlasHulls(const SImage& image, int tilesX, int tilesY, const SHullSettings& settings);
+
+bool SaveAtlasHulls(const std::string& path, const SAtlasHulls& hulls, std::string& error);
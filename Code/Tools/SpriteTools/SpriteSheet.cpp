@@ -0,0 +1,642 @@
+#include "SpriteSheet.h"
+#include "SpriteHull.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+    bool IsValidEventType(const std::string& type)
+    {
+        return type == "hit" || type == "footstep";
+    }
+
+    // FNV-1a over the placement and pixels, identical frames always collide
+    uint64_t HashFrame(const STrimmedFrame& frame)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                hash ^= (value >> (i * 8)) & 0xFF;
+                hash *= 1099511628211ull;
+            }
+        };
+
+        mix(uint32_t(frame.image.width));
+        mix(uint32_t(frame.image.height));
+        mix(uint32_t(frame.sourceWidth));
+        mix(uint32_t(frame.sourceHeight));
+        mix(uint32_t(frame.offsetX));
+        mix(uint32_t(frame.offsetY));
+        for (uint32_t pixel : frame.image.pixels)
+        {
+            mix(pixel);
+        }
+        return hash;
+    }
+
+    bool IsSameFrame(const STrimmedFrame& a, const STrimmedFrame& b)
+    {
+        return a.hash == b.hash &&
+            a.image.width == b.image.width && a.image.height == b.image.height &&
+            a.sourceWidth == b.sourceWidth && a.sourceHeight == b.sourceHeight &&
+            a.offsetX == b.offsetX && a.offsetY == b.offsetY &&
+            a.image.pixels == b.image.pixels;
+    }
+
+    int NextPowerOfTwo(int value)
+    {
+        int result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    struct SPackRect
+    {
+        int frame;
+        int width;
+        int height;
+    };
+
+    struct SSkylineSegment
+    {
+        int x;
+        int y;
+        int width;
+    };
+
+    // Bottom-left skyline packing into a fixed width, returns the used height or -1 when a rectangle is wider than the atlas
+    int PackSkyline(const std::vector<SPackRect>& rects, int width, int maxHeight, std::vector<SPackedFrame>& frames, int padding)
+    {
+        std::vector<SSkylineSegment> skyline = { { 0, 0, width } };
+        int usedHeight = 0;
+
+        for (const SPackRect& rect : rects)
+        {
+            if (rect.width > width)
+                return -1;
+
+            // Lowest position the rectangle can rest on, ties go to the segment that wastes the least width
+            int bestIndex = -1;
+            int bestY = std::numeric_limits<int>::max();
+            int bestWaste = std::numeric_limits<int>::max();
+
+            for (size_t i = 0; i < skyline.size(); ++i)
+            {
+                if (skyline[i].x + rect.width > width)
+                    break;
+
+                int y = 0;
+                int remaining = rect.width;
+                size_t j = i;
+                while (remaining > 0)
+                {
+                    y = std::max(y, skyline[j].y);
+                    remaining -= skyline[j].width;
+                    ++j;
+                }
+
+                const int waste = skyline[i].width >= rect.width ? skyline[i].width - rect.width : 0;
+                if (y < bestY || (y == bestY && waste < bestWaste))
+                {
+                    bestIndex = int(i);
+                    bestY = y;
+                    bestWaste = waste;
+                }
+            }
+
+            if (bestIndex < 0 || bestY + rect.height > maxHeight)
+                return -1;
+
+            SPackedFrame& packed = frames[rect.frame];
+            packed.x = skyline[bestIndex].x + padding / 2;
+            packed.y = bestY + padding / 2;
+            usedHeight = std::max(usedHeight, bestY + rect.height);
+
+            // Raise the skyline under the rectangle and trim the segments it covers
+            const SSkylineSegment raised = { skyline[bestIndex].x, bestY + rect.height, rect.width };
+            const int right = raised.x + raised.width;
+            size_t next = bestIndex;
+            while (next < skyline.size() && skyline[next].x + skyline[next].width <= right)
+                ++next;
+
+            if (next < skyline.size() && skyline[next].x < right)
+            {
+                skyline[next].width -= right - skyline[next].x;
+                skyline[next].x = right;
+            }
+
+            skyline.erase(skyline.begin() + bestIndex, skyline.begin() + next);
+            skyline.insert(skyline.begin() + bestIndex, raised);
+
+            // Merge neighbours at the same height
+            for (size_t i = 1; i < skyline.size();)
+            {
+                if (skyline[i - 1].y == skyline[i].y)
+                {
+                    skyline[i - 1].width += skyline[i].width;
+                    skyline.erase(skyline.begin() + i);
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        }
+
+        return usedHeight;
+    }
+}
+
+bool LoadClipManifest(const std::string& path, std::vector<SClipDesc>& clips, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream stream(line);
+        std::string keyword;
+        if (!(stream >> keyword))
+            continue;
+
+        if (keyword == "clip")
+        {
+            SClipDesc clip;
+            std::string mode;
+            if (!(stream >> clip.name >> clip.folder >> clip.fps >> mode) || clip.fps <= 0.f || (mode != "loop" && mode != "once"))
+            {
+                error = path + ":" + std::to_string(lineNumber) + ": expected 'clip <name> <folder> <fps> <loop|once>'";
+                return false;
+            }
+
+            clip.loop = mode == "loop";
+            clips.push_back(std::move(clip));
+        }
+        else if (keyword == "event")
+        {
+            std::string clipName;
+            SClipEvent event;
+            if (!(stream >> clipName >> event.frame >> event.type) || event.frame < 0 || !IsValidEventType(event.type))
+            {
+                error = path + ":" + std::to_string(lineNumber) + ": expected 'event <clip> <frame> <hit|footstep>'";
+                return false;
+            }
+
+            auto it = std::find_if(clips.begin(), clips.end(), [&clipName](const SClipDesc& clip) { return clip.name == clipName; });
+            if (it == clips.end())
+            {
+                error = path + ":" + std::to_string(lineNumber) + ": event for unknown clip " + clipName;
+                return false;
+            }
+
+            it->events.push_back(event);
+        }
+        else
+        {
+            error = path + ":" + std::to_string(lineNumber) + ": unknown keyword " + keyword;
+            return false;
+        }
+    }
+
+    if (clips.empty())
+    {
+        error = path + " does not define any clips";
+        return false;
+    }
+
+    return true;
+}
+
+bool GatherClipFrames(const std::string& manifestPath, std::vector<SClipDesc>& clips, std::string& error)
+{
+    namespace fs = std::filesystem;
+
+    const fs::path root = fs::path(manifestPath).parent_path();
+
+    for (SClipDesc& clip : clips)
+    {
+        const fs::path folder = root / clip.folder;
+
+        std::error_code errorCode;
+        for (fs::directory_iterator it(folder, errorCode), end; !errorCode && it != end; it.increment(errorCode))
+        {
+            std::string extension = it->path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(std::tolower(c)); });
+
+            if (it->is_regular_file() && extension == ".tga")
+            {
+                clip.framePaths.push_back(it->path().string());
+            }
+        }
+
+        if (errorCode)
+        {
+            error = "Failed to list " + folder.string() + ": " + errorCode.message();
+            return false;
+        }
+
+        if (clip.framePaths.empty())
+        {
+            error = "Clip " + clip.name + " has no .tga frames in " + folder.string();
+            return false;
+        }
+
+        std::sort(clip.framePaths.begin(), clip.framePaths.end());
+
+        for (const SClipEvent& event : clip.events)
+        {
+            if (event.frame >= int(clip.framePaths.size()))
+            {
+                error = "Event on frame " + std::to_string(event.frame) + " is past the end of clip " + clip.name;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void ParallelFor(size_t count, int threadCount, const std::function<void(size_t)>& function)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = std::max(int(std::thread::hardware_concurrency()), 1);
+    }
+    threadCount = int(std::min<size_t>(size_t(threadCount), count));
+
+    if (threadCount <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            function(i);
+        return;
+    }
+
+    // Work is handed out one index at a time, frames vary too much in size for static ranges
+    std::atomic<size_t> nextIndex(0);
+    auto worker = [&]()
+    {
+        for (size_t i = nextIndex++; i < count; i = nextIndex++)
+            function(i);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (int i = 1; i < threadCount; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+STrimmedFrame TrimFrame(const SImage& image, int alphaThreshold)
+{
+    STrimmedFrame frame;
+    frame.sourceWidth = image.width;
+    frame.sourceHeight = image.height;
+
+    int minX = image.width, minY = image.height, maxX = -1, maxY = -1;
+    for (int y = 0; y < image.height; ++y)
+    {
+        for (int x = 0; x < image.width; ++x)
+        {
+            if (image.GetAlpha(x, y) > alphaThreshold)
+            {
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y);
+            }
+        }
+    }
+
+    // Fully transparent frames keep a single pixel so they still have a place in the atlas
+    if (maxX < 0)
+    {
+        minX = maxX = 0;
+        minY = maxY = 0;
+    }
+
+    frame.offsetX = minX;
+    frame.offsetY = minY;
+    frame.image.width = maxX - minX + 1;
+    frame.image.height = maxY - minY + 1;
+    frame.image.pixels.resize(size_t(frame.image.width) * frame.image.height);
+
+    for (int y = 0; y < frame.image.height; ++y)
+    {
+        const uint32_t* pSource = &image.pixels[size_t(minY + y) * image.width + minX];
+        std::copy(pSource, pSource + frame.image.width, &frame.image.pixels[size_t(y) * frame.image.width]);
+    }
+
+    // Transparent pixels only differ in their hidden colour, which should not prevent deduplication
+    for (uint32_t& pixel : frame.image.pixels)
+    {
+        if ((pixel >> 24) <= uint32_t(alphaThreshold))
+            pixel = 0;
+    }
+
+    frame.hash = HashFrame(frame);
+    return frame;
+}
+
+std::vector<int> DeduplicateFrames(const std::vector<STrimmedFrame>& frames, std::vector<int>& uniqueFrames)
+{
+    std::vector<int> remap(frames.size());
+    std::unordered_multimap<uint64_t, int> framesByHash;
+    framesByHash.reserve(frames.size());
+
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        int uniqueIndex = -1;
+
+        const auto range = framesByHash.equal_range(frames[i].hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (IsSameFrame(frames[uniqueFrames[it->second]], frames[i]))
+            {
+                uniqueIndex = it->second;
+                break;
+            }
+        }
+
+        if (uniqueIndex < 0)
+        {
+            uniqueIndex = int(uniqueFrames.size());
+            uniqueFrames.push_back(int(i));
+            framesByHash.emplace(frames[i].hash, uniqueIndex);
+        }
+
+        remap[i] = uniqueIndex;
+    }
+
+    return remap;
+}
+
+bool PackSpriteSheet(const std::vector<STrimmedFrame>& frames, const std::vector<int>& uniqueFrames, const SPackSettings& settings,
+    SSpriteSheet& sheet, std::string& error)
+{
+    sheet.frames.assign(uniqueFrames.size(), SPackedFrame());
+    sheet.sourceFrameCount = int(frames.size());
+    sheet.usedPixels = 0;
+    sheet.canvasWidth = 0;
+    sheet.canvasHeight = 0;
+
+    for (const STrimmedFrame& frame : frames)
+    {
+        sheet.canvasWidth = std::max(sheet.canvasWidth, frame.sourceWidth);
+        sheet.canvasHeight = std::max(sheet.canvasHeight, frame.sourceHeight);
+    }
+
+    std::vector<SPackRect> rects(uniqueFrames.size());
+    uint64_t paddedArea = 0;
+    int widestRect = 0;
+
+    for (size_t i = 0; i < uniqueFrames.size(); ++i)
+    {
+        const SImage& image = frames[uniqueFrames[i]].image;
+        SPackedFrame& packed = sheet.frames[i];
+        packed.sourceIndex = uniqueFrames[i];
+        packed.width = image.width;
+        packed.height = image.height;
+
+        rects[i] = { int(i), image.width + settings.padding, image.height + settings.padding };
+        paddedArea += uint64_t(rects[i].width) * rects[i].height;
+        widestRect = std::max(widestRect, rects[i].width);
+        sheet.usedPixels += uint64_t(image.width) * image.height;
+    }
+
+    // Tall rectangles first keeps the skyline flat
+    std::sort(rects.begin(), rects.end(), [](const SPackRect& a, const SPackRect& b)
+    {
+        return a.height != b.height ? a.height > b.height : a.width > b.width;
+    });
+
+    // Every candidate width is packed independently, the smallest resulting atlas wins
+    std::vector<int> candidateWidths;
+    const int minWidth = std::max(widestRect, int(std::sqrt(double(paddedArea)) * 0.5));
+    if (settings.powerOfTwo)
+    {
+        for (int width = NextPowerOfTwo(minWidth); width <= settings.maxAtlasSize; width <<= 1)
+            candidateWidths.push_back(width);
+    }
+    else
+    {
+        const int maxWidth = std::min(settings.maxAtlasSize, std::max(minWidth, int(std::sqrt(double(paddedArea)) * 2.0)));
+        const int steps = 32;
+        for (int i = 0; i <= steps; ++i)
+            candidateWidths.push_back(minWidth + (maxWidth - minWidth) * i / steps);
+        candidateWidths.erase(std::unique(candidateWidths.begin(), candidateWidths.end()), candidateWidths.end());
+    }
+
+    struct SCandidate
+    {
+        int width = 0;
+        int height = -1;
+        std::vector<SPackedFrame> frames;
+    };
+
+    std::vector<SCandidate> candidates(candidateWidths.size());
+    ParallelFor(candidates.size(), settings.threadCount, [&](size_t i)
+    {
+        SCandidate& candidate = candidates[i];
+        candidate.width = candidateWidths[i];
+        candidate.frames = sheet.frames;
+
+        const int usedHeight = PackSkyline(rects, candidate.width, settings.maxAtlasSize, candidate.frames, settings.padding);
+        if (usedHeight > 0)
+        {
+            candidate.height = settings.powerOfTwo ? NextPowerOfTwo(usedHeight) : usedHeight;
+        }
+    });
+
+    const SCandidate* pBest = nullptr;
+    for (const SCandidate& candidate : candidates)
+    {
+        if (candidate.height <= 0 || candidate.height > settings.maxAtlasSize)
+            continue;
+
+        const uint64_t area = uint64_t(candidate.width) * candidate.height;
+        if (!pBest)
+        {
+            pBest = &candidate;
+            continue;
+        }
+
+        // Prefer the smaller atlas, then the squarer one
+        const uint64_t bestArea = uint64_t(pBest->width) * pBest->height;
+        if (area < bestArea || (area == bestArea && std::abs(candidate.width - candidate.height) < std::abs(pBest->width - pBest->height)))
+        {
+            pBest = &candidate;
+        }
+    }
+
+    if (!pBest)
+    {
+        error = "Frames don't fit into a " + std::to_string(settings.maxAtlasSize) + "x" + std::to_string(settings.maxAtlasSize) + " atlas";
+        return false;
+    }
+
+    sheet.width = pBest->width;
+    sheet.height = pBest->height;
+    sheet.frames = pBest->frames;
+    return true;
+}
+
+void BuildSheetHulls(const std::vector<STrimmedFrame>& frames, const SPackSettings& settings, SSpriteSheet& sheet)
+{
+    if (settings.maxHullVertices <= 0)
+        return;
+
+    SHullSettings hullSettings;
+    hullSettings.alphaThreshold = settings.alphaThreshold;
+    hullSettings.maxVertices = settings.maxHullVertices;
+
+    ParallelFor(sheet.frames.size(), settings.threadCount, [&](size_t i)
+    {
+        SPackedFrame& packed = sheet.frames[i];
+        const SImage& image = frames[packed.sourceIndex].image;
+
+        const SFrameHull hull = BuildFrameHull(image, 0, 0, image.width, image.height, hullSettings);
+
+        // A hull that saves next to nothing over the trimmed rectangle is not worth the extra vertices
+        if (hull.vertices.size() < 3 || hull.hullPixels > 0.95 * double(image.width) * image.height)
+            return;
+
+        for (const SHullVertex& vertex : hull.vertices)
+        {
+            packed.hull.push_back(vertex.x);
+            packed.hull.push_back(vertex.y);
+        }
+    });
+}
+
+SImage ComposeAtlas(const std::vector<STrimmedFrame>& frames, const SSpriteSheet& sheet, const SPackSettings& settings)
+{
+    SImage atlas;
+    atlas.width = sheet.width;
+    atlas.height = sheet.height;
+    atlas.pixels.assign(size_t(atlas.width) * atlas.height, 0);
+
+    const int extrude = settings.padding / 2;
+
+    // Frames never overlap, including their extruded borders, so they can be written concurrently
+    ParallelFor(sheet.frames.size(), settings.threadCount, [&](size_t i)
+    {
+        const SPackedFrame& packed = sheet.frames[i];
+        const SImage& image = frames[packed.sourceIndex].image;
+
+        for (int y = -extrude; y < packed.height + extrude; ++y)
+        {
+            const int sourceY = std::min(std::max(y, 0), packed.height - 1);
+            const int atlasY = packed.y + y;
+            if (atlasY < 0 || atlasY >= atlas.height)
+                continue;
+
+            for (int x = -extrude; x < packed.width + extrude; ++x)
+            {
+                const int sourceX = std::min(std::max(x, 0), packed.width - 1);
+                const int atlasX = packed.x + x;
+                if (atlasX < 0 || atlasX >= atlas.width)
+                    continue;
+
+                atlas.pixels[size_t(atlasY) * atlas.width + atlasX] = image.GetPixel(sourceX, sourceY);
+            }
+        }
+    });
+
+    return atlas;
+}
+
+bool SaveSpriteSheet(const std::string& path, const SSpriteSheet& sheet, const std::vector<STrimmedFrame>& frames,
+    const std::vector<SClipDesc>& clips, std::string& error)
+{
+    FILE* pFile = std::fopen(path.c_str(), "w");
+    if (!pFile)
+    {
+        error = "Failed to create " + path;
+        return false;
+    }
+
+    std::fprintf(pFile, "spritesheet 1\n");
+    std::fprintf(pFile, "atlas %d %d %d %d\n", sheet.width, sheet.height, sheet.canvasWidth, sheet.canvasHeight);
+    std::fprintf(pFile, "stats %d %d %llu\n", sheet.sourceFrameCount, int(sheet.frames.size()), static_cast<unsigned long long>(sheet.usedPixels));
+
+    for (size_t i = 0; i < sheet.frames.size(); ++i)
+    {
+        const SPackedFrame& packed = sheet.frames[i];
+        const STrimmedFrame& frame = frames[packed.sourceIndex];
+
+        // Frames of different sizes share one canvas, centred horizontally and standing on its bottom edge
+        const int canvasX = frame.offsetX + (sheet.canvasWidth - frame.sourceWidth) / 2;
+        const int canvasY = frame.offsetY + sheet.canvasHeight - frame.sourceHeight;
+
+        const size_t vertexCount = packed.hull.size() / 2;
+        std::fprintf(pFile, "frame %d %d %d %d %d %d %d %d", int(i), packed.x, packed.y, packed.width, packed.height, canvasX, canvasY, int(vertexCount));
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            std::fprintf(pFile, " %.5f %.5f", packed.hull[v * 2] / packed.width, packed.hull[v * 2 + 1] / packed.height);
+        }
+        std::fprintf(pFile, "\n");
+    }
+
+    for (size_t c = 0; c < clips.size(); ++c)
+    {
+        const SClipDesc& clip = clips[c];
+        const std::vector<int>& clipFrames = sheet.clipFrames[c];
+
+        std::fprintf(pFile, "clip %s %g %d %d", clip.name.c_str(), clip.fps, clip.loop ? 1 : 0, int(clipFrames.size()));
+        for (int frameIndex : clipFrames)
+        {
+            std::fprintf(pFile, " %d", frameIndex);
+        }
+        std::fprintf(pFile, "\n");
+
+        for (const SClipEvent& event : clip.events)
+        {
+            std::fprintf(pFile, "event %s %d %s\n", clip.name.c_str(), event.frame, event.type.c_str());
+        }
+    }
+
+    const bool succeeded = std::ferror(pFile) == 0;
+    std::fclose(pFile);
+
+    if (!succeeded)
+    {
+        error = "Failed to write " + path;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Image.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////
+// Tightly packed sprite atlases built from folders of frame images
+//
+// The clip manifest lists one clip per line, frames are the .tga files of its folder in name order:
+//   clip <name> <folder> <fps> <loop|once>
+//   event <clip> <frame> <hit|footstep>
+// Folders are relative to the manifest, '#' starts a comment.
+//
+// The packed sheet is written as a text .spritesheet file next to the atlas material:
+//   spritesheet 1
+//   atlas <width> <height> <canvasWidth> <canvasHeight>
+//   stats <sourceFrames> <uniqueFrames> <usedPixels>
+//   frame <index> <x> <y> <width> <height> <canvasX> <canvasY> <vertexCount> <u0> <v0> ...
+//   clip <name> <fps> <loop> <frameCount> <frameIndex> ...
+//   event <clip> <frame> <hit|footstep>
+// Frame rectangles are in atlas pixels, their canvas offset is where the trimmed frame sits in
+// the untrimmed canvas. Hull vertices are in frame-local UV space (0..1, v down), a frame with
+// no vertices draws its whole rectangle.
+////////////////////////////////////////////////////////
+struct SClipEvent
+{
+    int frame = 0;
+    std::string type;
+};
+
+struct SClipDesc
+{
+    std::string name;
+    std::string folder;
+    float fps = 0.f;
+    bool loop = true;
+    std::vector<SClipEvent> events;
+
+    // Filled when the frames are gathered
+    std::vector<std::string> framePaths;
+};
+
+// A source frame with its fully transparent border removed
+struct STrimmedFrame
+{
+    SImage image;
+    int sourceWidth = 0;
+    int sourceHeight = 0;
+    // Position of the trimmed image inside the source frame
+    int offsetX = 0;
+    int offsetY = 0;
+    uint64_t hash = 0;
+};
+
+struct SPackedFrame
+{
+    // Index of the trimmed frame that provides the pixels
+    int sourceIndex = 0;
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    // Frame-local pixel coordinates, empty to draw the whole rectangle
+    std::vector<float> hull;
+};
+
+struct SPackSettings
+{
+    // Pixels with an alpha above this value are kept when trimming
+    int alphaThreshold = 0;
+    // Transparent pixels between frames, the frame edges are extruded into it to avoid bleeding
+    int padding = 2;
+    int maxAtlasSize = 8192;
+    bool powerOfTwo = true;
+    // Maximum vertices of the per-frame hull, 0 to draw trimmed rectangles
+    int maxHullVertices = 8;
+    int threadCount = 0;
+};
+
+struct SSpriteSheet
+{
+    int width = 0;
+    int height = 0;
+    int canvasWidth = 0;
+    int canvasHeight = 0;
+
+    std::vector<SPackedFrame> frames;
+    // Per clip, indices into frames
+    std::vector<std::vector<int>> clipFrames;
+
+    int sourceFrameCount = 0;
+    // Pixels covered by frame rectangles, without padding
+    uint64_t usedPixels = 0;
+};
+
+bool LoadClipManifest(const std::string& path, std::vector<SClipDesc>& clips, std::string& error);
+// Lists the frame images of every clip
+bool GatherClipFrames(const std::string& manifestPath, std::vector<SClipDesc>& clips, std::string& error);
+
+// Runs the function for every index on a pool of worker threads, 0 threads uses every core
+void ParallelFor(size_t count, int threadCount, const std::function<void(size_t)>& function);
+
+STrimmedFrame TrimFrame(const SImage& image, int alphaThreshold);
+// Maps every frame to the first frame with identical pixels and placement, returned indices point into uniqueFrames
+std::vector<int> DeduplicateFrames(const std::vector<STrimmedFrame>& frames, std::vector<int>& uniqueFrames);
+
+// Packs the unique frames, returns false when they don't fit into the maximum atlas size
+bool PackSpriteSheet(const std::vector<STrimmedFrame>& frames, const std::vector<int>& uniqueFrames, const SPackSettings& settings,
+    SSpriteSheet& sheet, std::string& error);
+void BuildSheetHulls(const std::vector<STrimmedFrame>& frames, const SPackSettings& settings, SSpriteSheet& sheet);
+SImage ComposeAtlas(const std::vector<STrimmedFrame>& frames, const SSpriteSheet& sheet, const SPackSettings& settings);
+
+bool SaveSpriteSheet(const std::string& path, const SSpriteSheet& sheet, const std::vector<STrimmedFrame>& frames,
+    const std::vector<SClipDesc>& clips, std::string& error);